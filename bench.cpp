@@ -0,0 +1,686 @@
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#include <fnmatch.h>
+
+#include <arm_neon.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "bench_baseline.h"
+#include "bench_counters.h"
+
+namespace {
+
+struct result {
+  const bench_case* c;
+  size_t size;
+  size_t elems;
+  size_t bytes;
+  bench_traffic traffic;
+  uint64_t iters;
+  std::vector<double> samples;  // ns per call
+  double median;
+  double min;
+  double stddev;
+  std::vector<std::pair<std::string, double>> counters;
+};
+
+std::vector<std::string> split(const std::string& list)
+{
+  std::vector<std::string> items;
+  size_t pos = 0;
+  while (pos <= list.size()) {
+    const auto comma = std::min(list.find(',', pos), list.size());
+    items.push_back(list.substr(pos, comma - pos));
+    pos = comma + 1;
+  }
+  return items;
+}
+
+void usage(const char* argv0)
+{
+  printf("usage: %s [options]\n"
+         "  --filter LIST      run cases matching any comma-separated pattern (glob,\n"
+         "                     or substring without '*'); may be repeated\n"
+         "  --list             list the cases with their sizes and exit\n"
+         "  --select NAME:N    only the case NAME with shift count N (-1 for none)\n"
+         "  --sizes LIST       working-set sizes, e.g. 16K,256K,4M (default: cache sweep)\n"
+         "  --reps N           timed repetitions (default 5)\n"
+         "  --warmup N         untimed calls before timing (default 1)\n"
+         "  --min-time-ms MS   minimum duration of one repetition (default 1)\n"
+         "  --format FMT       text, csv or json (default text)\n"
+         "  --out FILE         write results to FILE instead of stdout\n"
+         "  --counters         add cycles, instructions, IPC, cache and branch misses\n"
+         "                     per element from perf_event_open where available\n"
+         "  --roofline         measure read/write/copy bandwidth per size and report\n"
+         "                     each case's fraction of it and its intensity\n"
+         "  --save-baseline FILE  store the samples under this CPU, compiler and flags\n"
+         "  --compare FILE     compare with the stored samples; exit 2 when a gated\n"
+         "                     case is significantly slower, 1 when FILE has no\n"
+         "                     section for this CPU, compiler and flags\n"
+         "  --gate LIST        cases that fail the comparison (default: the NEON,\n"
+         "                     bulk, pipeline and arena kernels)\n"
+         "  --threshold PCT    slowdown of the median that counts (default 10)\n"
+         "  --alpha P          significance of the Mann-Whitney test (default 0.01)\n"
+         "  --icount K         call each case K times untimed at each of --sizes and\n"
+         "                     print name,width,n,size,elems,calls (see qemu_icount.sh)\n"
+         "  --tune FILE        autotune the bulk rotations, save the result to FILE\n"
+         "                     and use it for the benchmarks\n"
+         "  --stats            print the counters of the bulk rotations to stderr at\n"
+         "                     the end (cmake -DMY_STATS=ON)\n"
+         "  --no-test          skip the correctness tests\n"
+         "  --no-bench         run the correctness tests only\n", argv0);
+}
+
+bool parse_size(const std::string& s, size_t* out)
+{
+  char* end = nullptr;
+  const auto v = strtod(s.c_str(), &end);
+  if (end == s.c_str() || v <= 0) {
+    return false;
+  }
+  double mul = 1;
+  switch (*end) {
+  case 'k': case 'K': mul = 1024; ++end; break;
+  case 'm': case 'M': mul = 1024 * 1024; ++end; break;
+  case 'g': case 'G': mul = 1024 * 1024 * 1024; ++end; break;
+  default: break;
+  }
+  if (*end != '\0') {
+    return false;
+  }
+  *out = static_cast<size_t>(v * mul);
+  return true;
+}
+
+std::string format_size(size_t bytes)
+{
+  char buf[32];
+  if (bytes >= 1024 * 1024 && bytes % (1024 * 1024) == 0) {
+    snprintf(buf, sizeof(buf), "%zuM", bytes / (1024 * 1024));
+  } else if (bytes >= 1024 && bytes % 1024 == 0) {
+    snprintf(buf, sizeof(buf), "%zuK", bytes / 1024);
+  } else {
+    snprintf(buf, sizeof(buf), "%zu", bytes);
+  }
+  return buf;
+}
+
+// Data and unified cache sizes of cpu0 from sysfs, smallest first.
+std::vector<size_t> cache_sizes()
+{
+  std::vector<size_t> sizes;
+  for (int i = 0; i < 8; ++i) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", i);
+    auto f = fopen(path, "r");
+    if (!f) {
+      break;
+    }
+    char type[32] = {};
+    const auto ok = fscanf(f, "%31s", type) == 1;
+    fclose(f);
+    if (!ok || strcmp(type, "Instruction") == 0) {
+      continue;
+    }
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", i);
+    f = fopen(path, "r");
+    if (!f) {
+      continue;
+    }
+    char size[32] = {};
+    size_t bytes = 0;
+    if (fscanf(f, "%31s", size) == 1 && parse_size(size, &bytes)) {
+      sizes.push_back(bytes);
+    }
+    fclose(f);
+  }
+  std::sort(sizes.begin(), sizes.end());
+  sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+  return sizes;
+}
+
+// Half of each cache level, and a DRAM-sized set well past the last level.
+std::vector<size_t> default_sizes()
+{
+  auto caches = cache_sizes();
+  if (caches.empty()) {
+    caches = { 32 * 1024, 512 * 1024, 4 * 1024 * 1024 };
+  }
+  std::vector<size_t> sizes;
+  for (const auto c : caches) {
+    sizes.push_back(c / 2);
+  }
+  sizes.push_back(std::max<size_t>(8 * caches.back(), 64 * 1024 * 1024));
+  return sizes;
+}
+
+bool matches(const std::string& name, const std::vector<std::string>& filters)
+{
+  if (filters.empty()) {
+    return true;
+  }
+  for (const auto& f : filters) {
+    const auto pattern = f.find_first_of("*?[") == std::string::npos ? "*" + f + "*" : f;
+    if (fnmatch(pattern.c_str(), name.c_str(), 0) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+double time_ns(const bench_run& r, uint64_t iters)
+{
+  const auto begin = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < iters; ++i) {
+    r.run();
+  }
+  const auto end = std::chrono::steady_clock::now();
+  return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+}
+
+result measure(const bench_case& c, size_t size, const bench_options& opt, bench_counters* counters)
+{
+  const auto r = c.prepare(size);
+  result res;
+  res.c = &c;
+  res.size = size;
+  res.elems = r.elems;
+  res.bytes = r.bytes;
+  res.traffic = r.traffic;
+  res.counters = r.counters;
+
+  for (int i = 0; i < opt.warmup; ++i) {
+    r.run();
+  }
+  const auto min_ns = opt.min_time_ms * 1e6;
+  uint64_t iters = 1;
+  while (iters < (1ULL << 30)) {
+    const auto t = time_ns(r, iters);
+    if (t >= min_ns) {
+      break;
+    }
+    // Aim a little past the minimum, at most 10x per step.
+    const auto scale = t > 0 ? std::min(10.0, 1.2 * min_ns / t) : 10.0;
+    iters = std::max<uint64_t>(iters + 1, static_cast<uint64_t>(iters * scale));
+  }
+  res.iters = iters;
+
+  if (counters) {
+    counters->start();
+  }
+  for (int i = 0; i < opt.reps; ++i) {
+    res.samples.push_back(time_ns(r, iters) / iters);
+  }
+  if (counters) {
+    counters->stop();
+    for (const auto& p : counters->per_elem(iters * opt.reps, r.elems)) {
+      res.counters.push_back(p);
+    }
+  }
+  if (r.teardown) {
+    r.teardown();
+  }
+  auto sorted = res.samples;
+  std::sort(sorted.begin(), sorted.end());
+  const auto m = sorted.size();
+  res.median = m % 2 ? sorted[m / 2] : (sorted[m / 2 - 1] + sorted[m / 2]) / 2;
+  res.min = sorted.front();
+  double mean = 0;
+  for (const auto s : sorted) {
+    mean += s;
+  }
+  mean /= m;
+  double var = 0;
+  for (const auto s : sorted) {
+    var += (s - mean) * (s - mean);
+  }
+  res.stddev = m > 1 ? std::sqrt(var / (m - 1)) : 0;
+  return res;
+}
+
+// Best read, write and copy bandwidth in GB/s for one working-set size.
+struct roof {
+  double read;
+  double write;
+  double copy;
+};
+
+roof measure_roof(size_t size, const bench_options& opt)
+{
+  const bench_case read = bench_buffer<uint64_t>("roofline/read", 64, -1, [](uint64_t* d, size_t len) {
+    auto a = vdupq_n_u64(0);
+    auto b = a, c = a, e = a;
+    for (size_t i = 0; i < len; i += 8) {
+      a = veorq_u64(a, vld1q_u64(d + i));
+      b = veorq_u64(b, vld1q_u64(d + i + 2));
+      c = veorq_u64(c, vld1q_u64(d + i + 4));
+      e = veorq_u64(e, vld1q_u64(d + i + 6));
+    }
+    vst1q_u64(d, veorq_u64(veorq_u64(a, b), veorq_u64(c, e)));
+  }, bench_traffic::read);
+  const bench_case write = bench_buffer<uint64_t>("roofline/write", 64, -1, [](uint64_t* d, size_t len) {
+    memset(d, 0x5a, len * sizeof(uint64_t));
+  });
+  const bench_case copy = bench_kernel<uint64_t>("roofline/copy", 64, -1, [](const uint64_t* s, uint64_t* d, size_t len) {
+    memcpy(d, s, len * sizeof(uint64_t));
+  });
+  const auto best = [&](const bench_case& c) {
+    const auto r = measure(c, size, opt, nullptr);
+    return r.min > 0 ? r.bytes / r.min : 0;
+  };
+  return { best(read), best(write), best(copy) };
+}
+
+double roof_gb_per_s(const roof& roof, bench_traffic traffic)
+{
+  switch (traffic) {
+  case bench_traffic::read:
+    return roof.read;
+  case bench_traffic::write:
+    return roof.write;
+  default:
+    return roof.copy;
+  }
+}
+
+double ns_per_elem(const result& r)
+{
+  return r.elems ? r.median / r.elems : 0;
+}
+
+double gb_per_s(const result& r)
+{
+  return r.median > 0 ? r.bytes / r.median : 0;
+}
+
+// Adds the ceiling for the case's traffic at its size, the fraction of it
+// that the case reaches, and its arithmetic intensity: elements (one
+// operation each) per byte, and instructions per byte with --counters.
+void add_roofline(result* r, const roof& roof)
+{
+  const auto ceiling = roof_gb_per_s(roof, r->traffic);
+  const auto per_byte = static_cast<double>(r->elems) / r->bytes;
+  double insns = -1;
+  for (const auto& c : r->counters) {
+    if (c.first == "insns/elem") {
+      insns = c.second;
+    }
+  }
+  r->counters.push_back({ "roof_gbps", ceiling });
+  r->counters.push_back({ "roof_frac", ceiling > 0 ? gb_per_s(*r) / ceiling : 0 });
+  r->counters.push_back({ "elems/byte", per_byte });
+  if (insns >= 0) {
+    r->counters.push_back({ "insns/byte", insns * per_byte });
+  }
+}
+
+bool selected(const bench_case& c, const bench_options& opt)
+{
+  return matches(c.name, opt.filters) && (opt.select.empty() || (c.name == opt.select && c.n == opt.select_n));
+}
+
+// A case's own sizes win over the sweep, except that --icount runs exactly
+// the sizes given, so that a script can pick one.
+const std::vector<size_t>& sizes_for(const bench_case& c, const std::vector<size_t>& sweep,
+                                     const bench_options& opt)
+{
+  return c.sizes.empty() || (opt.icount && !opt.sizes.empty()) ? sweep : c.sizes;
+}
+
+double median(std::vector<double> v)
+{
+  std::sort(v.begin(), v.end());
+  const auto m = v.size();
+  return m == 0 ? 0 : m % 2 ? v[m / 2] : (v[m / 2 - 1] + v[m / 2]) / 2;
+}
+
+// Prints every significant slowdown to stderr; returns the number of them
+// in gated cases.
+int compare(const std::vector<bench_samples>& base, const std::vector<bench_samples>& cur,
+            const bench_options& opt)
+{
+  int compared = 0;
+  int regressions = 0;
+  int gated = 0;
+  int untestable = 0;
+  for (const auto& c : cur) {
+    const auto b = std::find_if(base.begin(), base.end(), [&](const bench_samples& b) {
+      return b.name == c.name && b.width == c.width && b.n == c.n && b.size == c.size;
+    });
+    if (b == base.end()) {
+      continue;
+    }
+    ++compared;
+    if (bench_mann_whitney_min_p(b->samples.size(), c.samples.size()) >= opt.alpha) {
+      ++untestable;
+      continue;
+    }
+    const auto slowdown = median(c.samples) / median(b->samples) - 1;
+    const auto p = bench_mann_whitney_greater(b->samples, c.samples);
+    if (p >= opt.alpha || slowdown <= opt.threshold) {
+      continue;
+    }
+    const auto gate = matches(c.name, opt.gate);
+    ++regressions;
+    gated += gate;
+    fprintf(stderr, "%s %s n=%d %s: %+.1f%% (p=%.4f)\n", gate ? "REGRESSION" : "slower    ",
+            c.name.c_str(), c.n, format_size(c.size).c_str(), 100 * slowdown, p);
+  }
+  fprintf(stderr, "compared %d cases with the baseline: %d slower, %d in gated cases\n",
+          compared, regressions, gated);
+  if (untestable) {
+    fprintf(stderr, "%d cases have too few samples in the baseline to be significant at --alpha %g\n",
+            untestable, opt.alpha);
+  }
+  return gated;
+}
+
+void print_text(FILE* f, const result& r)
+{
+  fprintf(f, "%-36s %3d %3d %6s %14.1f %14.1f %6.2f%% %10.4f",
+          r.c->name.c_str(), r.c->width, r.c->n, format_size(r.size).c_str(),
+          r.median, r.min, r.median > 0 ? 100 * r.stddev / r.median : 0, ns_per_elem(r));
+  // Register-only cases move no memory.
+  if (r.bytes) {
+    fprintf(f, " %8.3f", gb_per_s(r));
+  } else {
+    fprintf(f, " %8s", "-");
+  }
+  for (const auto& c : r.counters) {
+    fprintf(f, " %s=%g", c.first.c_str(), c.second);
+  }
+  fprintf(f, "\n");
+}
+
+void print_csv(FILE* f, const result& r)
+{
+  fprintf(f, "%s,%d,%d,%zu,%zu,%zu,%" PRIu64 ",%zu,%.3f,%.3f,%.3f,%.6f,%.6f",
+          r.c->name.c_str(), r.c->width, r.c->n, r.size, r.elems, r.bytes, r.iters, r.samples.size(),
+          r.median, r.min, r.stddev, ns_per_elem(r), gb_per_s(r));
+  for (const auto& c : r.counters) {
+    fprintf(f, ",%s=%g", c.first.c_str(), c.second);
+  }
+  fprintf(f, "\n");
+}
+
+void print_json(FILE* f, const result& r, bool first)
+{
+  fprintf(f, "%s\n    {\"name\": \"%s\", \"width\": %d, \"n\": %d, \"size\": %zu, \"elems\": %zu, "
+          "\"bytes\": %zu, \"iters\": %" PRIu64 ", \"reps\": %zu, \"median_ns\": %.3f, \"min_ns\": %.3f, "
+          "\"stddev_ns\": %.3f, \"ns_per_elem\": %.6f, \"gb_per_s\": %.6f, \"counters\": {",
+          first ? "" : ",", r.c->name.c_str(), r.c->width, r.c->n, r.size, r.elems, r.bytes, r.iters,
+          r.samples.size(), r.median, r.min, r.stddev, ns_per_elem(r), gb_per_s(r));
+  for (size_t i = 0; i < r.counters.size(); ++i) {
+    fprintf(f, "%s\"%s\": %g", i ? ", " : "", r.counters[i].first.c_str(), r.counters[i].second);
+  }
+  fprintf(f, "}}");
+}
+
+} // namespace
+
+bool bench_parse_args(int argc, const char* argv[], bench_options* opt)
+{
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const auto value = [&](const char** v) {
+      if (i + 1 >= argc) {
+        fprintf(stderr, "%s needs a value\n", arg.c_str());
+        return false;
+      }
+      *v = argv[++i];
+      return true;
+    };
+    const char* v = nullptr;
+    if (arg == "--filter") {
+      if (!value(&v)) {
+        return false;
+      }
+      for (const auto& f : split(v)) {
+        opt->filters.push_back(f);
+      }
+    } else if (arg == "--list") {
+      opt->list = true;
+    } else if (arg == "--sizes") {
+      if (!value(&v)) {
+        return false;
+      }
+      for (const auto& item : split(v)) {
+        size_t bytes;
+        if (!parse_size(item, &bytes)) {
+          fprintf(stderr, "bad size list: %s\n", v);
+          return false;
+        }
+        opt->sizes.push_back(bytes);
+      }
+    } else if (arg == "--reps" || arg == "--warmup") {
+      if (!value(&v)) {
+        return false;
+      }
+      const auto n = atoi(v);
+      if (n < (arg == "--reps" ? 1 : 0)) {
+        fprintf(stderr, "bad %s: %s\n", arg.c_str(), v);
+        return false;
+      }
+      (arg == "--reps" ? opt->reps : opt->warmup) = n;
+    } else if (arg == "--min-time-ms") {
+      if (!value(&v)) {
+        return false;
+      }
+      opt->min_time_ms = atof(v);
+    } else if (arg == "--save-baseline" || arg == "--compare") {
+      if (!value(&v)) {
+        return false;
+      }
+      (arg == "--compare" ? opt->compare_baseline : opt->save_baseline) = v;
+    } else if (arg == "--stats") {
+      opt->stats = true;
+    } else if (arg == "--tune") {
+      if (!value(&v)) {
+        return false;
+      }
+      opt->tune = v;
+    } else if (arg == "--select") {
+      if (!value(&v)) {
+        return false;
+      }
+      opt->select = v;
+      const auto colon = opt->select.rfind(':');
+      if (colon != std::string::npos) {
+        opt->select_n = atoi(opt->select.c_str() + colon + 1);
+        opt->select.resize(colon);
+      }
+    } else if (arg == "--icount") {
+      if (!value(&v)) {
+        return false;
+      }
+      opt->icount = strtoull(v, nullptr, 10);
+    } else if (arg == "--gate") {
+      if (!value(&v)) {
+        return false;
+      }
+      opt->gate = split(v);
+    } else if (arg == "--threshold") {
+      if (!value(&v)) {
+        return false;
+      }
+      opt->threshold = atof(v) / 100;
+    } else if (arg == "--alpha") {
+      if (!value(&v)) {
+        return false;
+      }
+      opt->alpha = atof(v);
+    } else if (arg == "--format") {
+      if (!value(&v)) {
+        return false;
+      }
+      opt->format = v;
+      if (opt->format != "text" && opt->format != "csv" && opt->format != "json") {
+        fprintf(stderr, "bad format: %s\n", v);
+        return false;
+      }
+    } else if (arg == "--out") {
+      if (!value(&v)) {
+        return false;
+      }
+      opt->out = v;
+    } else if (arg == "--roofline") {
+      opt->roofline = true;
+    } else if (arg == "--counters") {
+      opt->counters = true;
+    } else if (arg == "--no-test") {
+      opt->test = false;
+    } else if (arg == "--no-bench") {
+      opt->bench = false;
+    } else {
+      usage(argv[0]);
+      return false;
+    }
+  }
+  const auto min_p = bench_mann_whitney_min_p(opt->reps, opt->reps);
+  if (!opt->compare_baseline.empty() && min_p >= opt->alpha) {
+    fprintf(stderr, "--compare: with --reps %d no p is below %.4f, so --alpha %g can never fail; "
+            "use more repetitions\n", opt->reps, min_p, opt->alpha);
+    return false;
+  }
+  return true;
+}
+
+int bench_run_all(const bench_registry& registry, const bench_options& opt)
+{
+  const auto sweep = opt.sizes.empty() ? default_sizes() : opt.sizes;
+  if (opt.list) {
+    for (const auto& c : registry.cases()) {
+      if (selected(c, opt)) {
+        for (const auto size : sizes_for(c, sweep, opt)) {
+          printf("%s %d %d %zu\n", c.name.c_str(), c.width, c.n, size);
+        }
+      }
+    }
+    return 0;
+  }
+  if (opt.icount) {
+    for (const auto& c : registry.cases()) {
+      if (selected(c, opt)) {
+        for (const auto size : sizes_for(c, sweep, opt)) {
+          const auto r = c.prepare(size);
+          for (uint64_t i = 0; i < opt.icount; ++i) {
+            r.run();
+          }
+          if (r.teardown) {
+            r.teardown();
+          }
+          printf("%s,%d,%d,%zu,%zu,%" PRIu64 "\n", c.name.c_str(), c.width, c.n, size, r.elems, opt.icount);
+        }
+      }
+    }
+    return 0;
+  }
+
+  FILE* f = stdout;
+  if (!opt.out.empty()) {
+    f = fopen(opt.out.c_str(), "w");
+    if (!f) {
+      fprintf(stderr, "cannot open %s\n", opt.out.c_str());
+      return 1;
+    }
+  }
+
+  std::unique_ptr<bench_counters> counters;
+  if (opt.counters) {
+    counters.reset(new bench_counters());
+    if (!counters->available()) {
+      fprintf(stderr, "hardware counters unavailable (%s), timing only\n", counters->error().c_str());
+      counters.reset();
+    }
+  }
+
+  // Ceilings are measured when a case that moves memory first needs them.
+  std::map<size_t, roof> roofs;
+
+  if (opt.format == "text") {
+    fprintf(f, "%-36s %3s %3s %6s %14s %14s %7s %10s %8s\n",
+            "name", "w", "n", "size", "median ns", "min ns", "stddev", "ns/elem", "GB/s");
+  } else if (opt.format == "csv") {
+    fprintf(f, "name,width,n,size,elems,bytes,iters,reps,median_ns,min_ns,stddev_ns,ns_per_elem,gb_per_s\n");
+  } else {
+    fprintf(f, "{\n  \"context\": {\"key\": \"%s\", \"reps\": %d, \"min_time_ms\": %g, \"counters\": %s},\n"
+            "  \"results\": [", bench_context_key().c_str(), opt.reps, opt.min_time_ms, counters ? "true" : "false");
+  }
+
+  std::vector<bench_samples> samples;
+  bool first = true;
+  for (const auto& c : registry.cases()) {
+    if (!selected(c, opt)) {
+      continue;
+    }
+    for (const auto size : sizes_for(c, sweep, opt)) {
+      auto r = measure(c, size, opt, counters.get());
+      if (opt.roofline && r.bytes) {
+        if (!roofs.count(size)) {
+          roofs[size] = measure_roof(size, opt);
+        }
+        add_roofline(&r, roofs[size]);
+      }
+      if (opt.format == "text") {
+        print_text(f, r);
+      } else if (opt.format == "csv") {
+        print_csv(f, r);
+      } else {
+        print_json(f, r, first);
+      }
+      first = false;
+      fflush(f);
+      samples.push_back({ c.name, c.width, c.n, size, r.samples });
+    }
+  }
+  if (opt.format == "text") {
+    for (const auto& p : roofs) {
+      fprintf(f, "# roofline %6s: read %8.3f GB/s, write %8.3f GB/s, copy %8.3f GB/s\n",
+              format_size(p.first).c_str(), p.second.read, p.second.write, p.second.copy);
+    }
+  } else if (opt.format == "json") {
+    fprintf(f, "\n  ],\n  \"roofline\": [");
+    bool first_roof = true;
+    for (const auto& p : roofs) {
+      fprintf(f, "%s\n    {\"size\": %zu, \"read_gbps\": %.6f, \"write_gbps\": %.6f, \"copy_gbps\": %.6f}",
+              first_roof ? "" : ",", p.first, p.second.read, p.second.write, p.second.copy);
+      first_roof = false;
+    }
+    fprintf(f, "\n  ]\n}\n");
+  }
+  if (f != stdout) {
+    fclose(f);
+  }
+
+  const auto key = bench_context_key();
+  if (!opt.save_baseline.empty() && !bench_save_baseline(opt.save_baseline, key, samples)) {
+    fprintf(stderr, "cannot write %s\n", opt.save_baseline.c_str());
+    return 1;
+  }
+  if (!opt.compare_baseline.empty()) {
+    std::vector<bench_samples> base;
+    if (!bench_load_baseline(opt.compare_baseline, key, &base)) {
+      // A new compiler or core has no section yet; passing here would let
+      // every regression through until someone records one.
+      fprintf(stderr, "no baseline for \"%s\" in %s; record one with --save-baseline\n",
+              key.c_str(), opt.compare_baseline.c_str());
+      return 1;
+    }
+    if (compare(base, samples, opt) > 0) {
+      return 2;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,286 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "neon_xoshiro.h"
+
+// Micro-benchmark runner. Every perf_* function registers cases; a case is
+// prepared for a working-set size and returns a closure that is timed.
+//
+// For each case and size the runner warms up, picks an iteration count so
+// that one repetition takes at least --min-time-ms, and then reports the
+// median, minimum and standard deviation of the time per call over --reps
+// repetitions, as well as ns per element and GB/s.
+
+// The bandwidth ceiling a case is compared with in roofline mode: data
+// read and written in equal parts, or mostly read, or mostly written.
+enum class bench_traffic { copy, read, write };
+
+struct bench_run {
+  std::function<void()> run;
+  // Elements processed and bytes read + written by one call of run.
+  size_t elems = 0;
+  size_t bytes = 0;
+  bench_traffic traffic = bench_traffic::copy;
+  // Extra per-case results, e.g. a false-positive rate.
+  std::vector<std::pair<std::string, double>> counters;
+  // Undoes what prepare changed outside the case, e.g. a forced backend;
+  // called after the last call of run.
+  std::function<void()> teardown;
+};
+
+struct bench_case {
+  // Slash-separated, e.g. "u32/q/neon".
+  std::string name;
+  // Element width in bits and shift count; 0 and -1 when they do not apply.
+  int width = 0;
+  int n = -1;
+  // Fixed sizes passed to prepare, for cases with a fixed shape such as a
+  // code length; empty for the cache-level sweep or --sizes.
+  std::vector<size_t> sizes;
+  std::function<bench_run(size_t bytes)> prepare;
+};
+
+class bench_registry {
+public:
+  void add(bench_case c)
+  {
+    cases_.push_back(std::move(c));
+  }
+
+  const std::vector<bench_case>& cases() const
+  {
+    return cases_;
+  }
+
+private:
+  std::vector<bench_case> cases_;
+};
+
+struct bench_options {
+  std::vector<std::string> filters;
+  std::vector<size_t> sizes;
+  int warmup = 1;
+  int reps = 5;
+  double min_time_ms = 1.0;
+  std::string format = "text";
+  std::string out;
+  bool list = false;
+  // Hardware counters per case, when perf_event_open allows it.
+  bool counters = false;
+  // Bandwidth ceilings per size and each case's fraction of its ceiling.
+  bool roofline = false;
+  // Baseline file to write, or to compare with; a comparison fails when a
+  // case matching gate is slower by more than threshold with p < alpha.
+  std::string save_baseline;
+  std::string compare_baseline;
+  // The vshlc kernels, and the bulk, pipeline and arena cases built on them;
+  // not the C backend or the neighbour workload of the streaming cases.
+  std::vector<std::string> gate = { "*/neon", "*/neon/*", "*/bulk/neon", "*/bulk/sha3", "*/bulk/sve2",
+                                    "*/bulk/stream", "*/bulk/cached", "*/pipeline/*", "*/arena/*" };
+  double threshold = 0.10;
+  double alpha = 0.01;
+  // One case by exact name and shift count, e.g. for instruction counting.
+  std::string select;
+  int select_n = -1;
+  // Run every selected case and size this many times, untimed.
+  uint64_t icount = 0;
+  // Autotune the bulk rotations first and save the result to this file.
+  std::string tune;
+  // Print the bulk rotation counters at the end (built with MY_STATS).
+  bool stats = false;
+  bool test = true;
+  bool bench = true;
+};
+
+// Parses the command line; returns false after printing usage or an error.
+bool bench_parse_args(int argc, const char* argv[], bench_options* opt);
+
+// Runs the cases that match the filters; returns the process exit code.
+int bench_run_all(const bench_registry& registry, const bench_options& opt);
+
+// Keeps the compiler from dropping work whose result is only in memory.
+static inline void bench_do_not_optimize(const void* p)
+{
+  asm volatile("" : : "r"(p) : "memory");
+}
+
+// A case that reads len elements from src and writes len elements to dst,
+// with src and dst splitting the working set. len is a multiple of 16.
+template<typename T, typename F>
+bench_case bench_kernel(const std::string& name, int width, int n, F f)
+{
+  bench_case c;
+  c.name = name;
+  c.width = width;
+  c.n = n;
+  c.prepare = [f](size_t bytes) {
+    auto len = bytes / (2 * sizeof(T)) & ~static_cast<size_t>(15);
+    len = len ? len : 16;
+    auto buf = std::make_shared<std::vector<T>>(2 * len);
+    neon_xoshiro128pp rng(1000);
+    rng.fill_bytes(buf->data(), len * sizeof(T));
+    bench_run r;
+    r.run = [buf, len, f]() {
+      f(buf->data(), buf->data() + len, len);
+      bench_do_not_optimize(buf->data() + len);
+    };
+    r.elems = len;
+    r.bytes = 2 * len * sizeof(T);
+    return r;
+  };
+  return c;
+}
+
+// A case that works on one buffer of len elements that fills the working
+// set: a generator output (write), or data updated in place (copy, which
+// counts the buffer as read and written). len is a multiple of 16.
+template<typename T, typename F>
+bench_case bench_buffer(const std::string& name, int width, int n, F f,
+                        bench_traffic traffic = bench_traffic::write)
+{
+  bench_case c;
+  c.name = name;
+  c.width = width;
+  c.n = n;
+  c.prepare = [f, traffic](size_t bytes) {
+    auto len = bytes / sizeof(T) & ~static_cast<size_t>(15);
+    len = len ? len : 16;
+    auto buf = std::make_shared<std::vector<T>>(len);
+    neon_xoshiro128pp rng(1000);
+    rng.fill_bytes(buf->data(), len * sizeof(T));
+    bench_run r;
+    r.run = [buf, len, f]() {
+      f(buf->data(), len);
+      bench_do_not_optimize(buf->data());
+    };
+    r.elems = len;
+    r.bytes = (traffic == bench_traffic::copy ? 2 : 1) * len * sizeof(T);
+    r.traffic = traffic;
+    return r;
+  };
+  return c;
+}
+
+// Register-resident chains for the latency and throughput modes.
+static const int kBenchChains = 8;
+static const size_t kBenchCalls = 4096;
+
+namespace bench_detail {
+
+// Keeps v in a register and opaque, so chains of rotations by a constant
+// are not folded.
+template<typename V>
+inline void keep(V& v)
+{
+#if defined(__arm__) || defined(__aarch64__)
+  if constexpr (std::is_integral<V>::value) {
+    asm volatile("" : "+r"(v));
+  } else {
+    asm volatile("" : "+w"(v));
+  }
+#else
+  asm volatile("" : "+m"(v));
+#endif
+}
+
+template<typename V, typename F, size_t... cs>
+void chains(V* v, size_t calls, F f, std::index_sequence<cs...>)
+{
+  static const size_t kChains = sizeof...(cs);
+  V c[kChains] = { v[cs]... };
+  for (size_t i = 0; i < calls; i += kChains) {
+    ((c[cs] = f(c[cs]), keep(c[cs])), ...);
+  }
+  ((v[cs] = c[cs]), ...);
+}
+
+} // namespace bench_detail
+
+// A case that calls f(v) -> v kBenchCalls times on values in registers,
+// either as one dependent chain or as kChains interleaved independent
+// chains. elems counts calls, so ns/elem is the latency of one call or its
+// reciprocal throughput.
+template<typename V, int kChains, typename F>
+bench_case bench_chain(const std::string& name, int width, int n, F f)
+{
+  bench_case c;
+  c.name = name;
+  c.width = width;
+  c.n = n;
+  c.sizes = { kChains * sizeof(V) };
+  c.prepare = [f](size_t) {
+    auto v = std::make_shared<std::vector<V>>(kChains);
+    neon_xoshiro128pp rng(1000);
+    rng.fill_bytes(v->data(), kChains * sizeof(V));
+    bench_run r;
+    r.run = [v, f]() {
+      bench_detail::chains(v->data(), kBenchCalls, f, std::make_index_sequence<kChains>());
+    };
+    r.elems = kBenchCalls;
+    return r;
+  };
+  return c;
+}
+
+namespace bench_detail {
+
+template<typename T, typename F, int... ns>
+void add_shifts(bench_registry* bench, const std::string& name, int width, F f,
+                std::integer_sequence<int, ns...>)
+{
+  (bench->add(bench_kernel<T>(name, width, ns + 1, [f](const T* s, T* d, size_t len) {
+    f(std::integral_constant<int, ns + 1>(), s, d, len);
+  })), ...);
+}
+
+template<typename V, typename F, int... ns>
+void add_chains(bench_registry* bench, const std::string& name, int width, F f,
+                std::integer_sequence<int, ns...>)
+{
+  (bench->add(bench_chain<V, 1>(name + "/lat", width, ns + 1, [f](V v) {
+    return f(std::integral_constant<int, ns + 1>(), v);
+  })), ...);
+  (bench->add(bench_chain<V, kBenchChains>(name + "/tput", width, ns + 1, [f](V v) {
+    return f(std::integral_constant<int, ns + 1>(), v);
+  })), ...);
+}
+
+} // namespace bench_detail
+
+// One bench_kernel per shift count 1 .. bits - 1; f(std::integral_constant<int, n>, src, dst, len).
+template<typename T, typename F>
+void bench_add_shifts(bench_registry* bench, const std::string& name, F f)
+{
+  static const int kBits = 8 * sizeof(T);
+  bench_detail::add_shifts<T>(bench, name, kBits, f, std::make_integer_sequence<int, kBits - 1>());
+}
+
+// Latency ("/lat") and throughput ("/tput") cases per shift count
+// 1 .. width - 1 for a rotation f(std::integral_constant<int, n>, v) -> v.
+template<typename V, int width, typename F>
+void bench_add_chains(bench_registry* bench, const std::string& name, F f)
+{
+  bench_detail::add_chains<V>(bench, name, width, f, std::make_integer_sequence<int, width - 1>());
+}
+
+#define BENCH_SHIFTS(bench, T, name, func) \
+  bench_add_shifts<T>(bench, name, [](auto n, const T* s, T* d, size_t len) { \
+    func<decltype(n)::value>(s, d, len); \
+  })
+
+#define BENCH_CHAINS(bench, V, width, name, func) \
+  bench_add_chains<V, width>(bench, name, [](auto n, V v) { \
+    return func<decltype(n)::value>(v); \
+  })
+
+#endif /* BENCH_H */
@@ -0,0 +1,194 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench_baseline.h"
+
+#ifndef BENCH_FLAGS
+#define BENCH_FLAGS "unknown"
+#endif
+
+namespace {
+
+std::string trim(const std::string& s)
+{
+  const auto b = s.find_first_not_of(" \t");
+  const auto e = s.find_last_not_of(" \t\r\n");
+  return b == std::string::npos ? std::string() : s.substr(b, e - b + 1);
+}
+
+// The model name, or the ARM implementer and part when there is none.
+std::string cpu_model()
+{
+  std::ifstream f("/proc/cpuinfo");
+  std::string line, model, implementer, part;
+  while (std::getline(f, line)) {
+    const auto colon = line.find(':');
+    if (colon == std::string::npos) {
+      continue;
+    }
+    const auto k = trim(line.substr(0, colon));
+    const auto v = trim(line.substr(colon + 1));
+    if (k == "model name" && model.empty()) {
+      model = v;
+    } else if (k == "CPU implementer" && implementer.empty()) {
+      implementer = v;
+    } else if (k == "CPU part" && part.empty()) {
+      part = v;
+    }
+  }
+  // ARM kernels report the architecture as the model name, so the part
+  // number tells the cores apart.
+  if (!part.empty()) {
+    model += (model.empty() ? "" : " ") + implementer + ":" + part;
+  }
+  return model.empty() ? "unknown" : model;
+}
+
+// Distribution of U for i values of a and j of b without ties, as counts.
+std::vector<double> u_counts(size_t n, size_t m)
+{
+  // f[i][j][u]: arrangements of i a's and j b's with U = u. The largest
+  // value is either an a (U unchanged) or a b (above all i a's).
+  std::vector<std::vector<std::vector<double>>> f(n + 1, std::vector<std::vector<double>>(m + 1));
+  for (size_t i = 0; i <= n; ++i) {
+    for (size_t j = 0; j <= m; ++j) {
+      f[i][j].assign(i * j + 1, 0);
+      if (i == 0 || j == 0) {
+        f[i][j][0] = 1;
+        continue;
+      }
+      for (size_t u = 0; u <= i * j; ++u) {
+        auto c = u <= (i - 1) * j ? f[i - 1][j][u] : 0;
+        if (u >= i && u - i <= i * (j - 1)) {
+          c += f[i][j - 1][u - i];
+        }
+        f[i][j][u] = c;
+      }
+    }
+  }
+  return f[n][m];
+}
+
+} // namespace
+
+std::string bench_context_key()
+{
+  return cpu_model() + " | " + __VERSION__ + " | " + BENCH_FLAGS;
+}
+
+bool bench_save_baseline(const std::string& path, const std::string& key,
+                         const std::vector<bench_samples>& results)
+{
+  // Keep the sections of other contexts.
+  std::vector<std::string> kept;
+  {
+    std::ifstream in(path);
+    std::string line;
+    bool skip = false;
+    while (std::getline(in, line)) {
+      if (line.compare(0, 4, "key ") == 0) {
+        skip = line.substr(4) == key;
+      }
+      if (!skip) {
+        kept.push_back(line);
+      }
+    }
+  }
+  FILE* f = fopen(path.c_str(), "w");
+  if (!f) {
+    return false;
+  }
+  for (const auto& line : kept) {
+    fprintf(f, "%s\n", line.c_str());
+  }
+  fprintf(f, "key %s\n", key.c_str());
+  for (const auto& r : results) {
+    fprintf(f, "%s %d %d %zu", r.name.c_str(), r.width, r.n, r.size);
+    for (const auto s : r.samples) {
+      fprintf(f, " %.3f", s);
+    }
+    fprintf(f, "\n");
+  }
+  return fclose(f) == 0;
+}
+
+bool bench_load_baseline(const std::string& path, const std::string& key,
+                         std::vector<bench_samples>* results)
+{
+  std::ifstream in(path);
+  std::string line;
+  bool found = false;
+  bool section = false;
+  while (std::getline(in, line)) {
+    if (line.compare(0, 4, "key ") == 0) {
+      section = line.substr(4) == key;
+      found |= section;
+      continue;
+    }
+    if (!section || line.empty()) {
+      continue;
+    }
+    std::istringstream ss(line);
+    bench_samples r;
+    if (!(ss >> r.name >> r.width >> r.n >> r.size)) {
+      continue;
+    }
+    double s;
+    while (ss >> s) {
+      r.samples.push_back(s);
+    }
+    results->push_back(r);
+  }
+  return found;
+}
+
+double bench_mann_whitney_greater(const std::vector<double>& a, const std::vector<double>& b)
+{
+  const auto n = a.size();
+  const auto m = b.size();
+  if (n == 0 || m == 0) {
+    return 1;
+  }
+  double u = 0;
+  for (const auto x : a) {
+    for (const auto y : b) {
+      u += x < y ? 1 : x == y ? 0.5 : 0;
+    }
+  }
+  if (n * m <= 400) {
+    // With ties the observed U can be a half; counting from its floor
+    // keeps the test conservative.
+    const auto counts = u_counts(n, m);
+    double total = 0;
+    double tail = 0;
+    for (size_t k = 0; k < counts.size(); ++k) {
+      total += counts[k];
+      if (k >= static_cast<size_t>(std::floor(u))) {
+        tail += counts[k];
+      }
+    }
+    return tail / total;
+  }
+  const auto mu = n * m / 2.0;
+  const auto sigma = std::sqrt(n * m * (n + m + 1) / 12.0);
+  const auto z = (u - mu - 0.5) / sigma;
+  return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+double bench_mann_whitney_min_p(size_t n, size_t m)
+{
+  double c = 1;
+  for (size_t k = 1; k <= n; ++k) {
+    c = c * (m + k) / k;
+  }
+  return 1 / c;
+}
@@ -0,0 +1,46 @@
+#ifndef BENCH_BASELINE_H
+#define BENCH_BASELINE_H
+
+#include <cstddef>
+
+#include <string>
+#include <vector>
+
+// Baseline store for the benchmark runner. A baseline file holds one
+// section per context (CPU model, compiler and flags) with the per-rep
+// samples of every case; saving replaces the section of the current
+// context and keeps the others.
+//
+// A later run is compared case by case with a one-sided Mann-Whitney U
+// test over the repetitions: a case regressed when its samples are slower
+// with p < alpha and its median is more than threshold slower as well, so
+// that neither noise nor a tiny but consistent shift fails the gate.
+
+struct bench_samples {
+  std::string name;
+  int width;
+  int n;
+  size_t size;
+  std::vector<double> samples;  // ns per call
+};
+
+// "cpu | compiler | flags" for the running binary.
+std::string bench_context_key();
+
+bool bench_save_baseline(const std::string& path, const std::string& key,
+                         const std::vector<bench_samples>& results);
+
+// Loads the section for key; false when the file or the section is missing.
+bool bench_load_baseline(const std::string& path, const std::string& key,
+                         std::vector<bench_samples>* results);
+
+// P(U >= observed) for the hypothesis that b is not larger than a, where U
+// counts pairs with a[i] < b[j] (ties count 1/2). Exact for small samples,
+// normal approximation otherwise.
+double bench_mann_whitney_greater(const std::vector<double>& a, const std::vector<double>& b);
+
+// The smallest p bench_mann_whitney_greater can return for n and m samples,
+// 1 / C(n + m, n): with too few repetitions no slowdown is significant.
+double bench_mann_whitney_min_p(size_t n, size_t m);
+
+#endif /* BENCH_BASELINE_H */
@@ -0,0 +1,132 @@
+#ifndef BENCH_BASELINES_H
+#define BENCH_BASELINES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if __has_include(<bit>)
+#include <bit>
+#endif
+
+#include <string>
+
+#include "bench.h"
+
+// Rotations written the ways the compiler is expected to handle on its own,
+// so that every NEON kernel is measured against the compiler's output:
+//
+// - std::rotl, when built as C++20 (cmake -DMY_CXX_STD=c++20);
+// - Clang's __builtin_rotateleft8/16/32/64;
+// - GCC vector extensions, which GCC and Clang lower to NEON shifts.
+//
+// The scalar loops are left to the auto-vectoriser. Each baseline is
+// registered only when the compiler provides it.
+
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_rotateleft32)
+#define BENCH_HAVE_BUILTIN_ROTATELEFT 1
+#endif
+#endif
+
+namespace bench_baselines_detail {
+
+template<typename T>
+struct vec {
+  typedef T type __attribute__((vector_size(16)));
+};
+
+template<typename T, int n>
+typename vec<T>::type vector_rotl(typename vec<T>::type v)
+{
+  return (v << n) | (v >> (8 * static_cast<int>(sizeof(T)) - n));
+}
+
+template<typename T, int n>
+void vector_loop(const T* s, T* d, size_t len)
+{
+  typedef typename vec<T>::type V;
+  for (size_t i = 0; i < len; i += sizeof(V) / sizeof(T)) {
+    V v;
+    memcpy(&v, s + i, sizeof(V));
+    v = vector_rotl<T, n>(v);
+    memcpy(d + i, &v, sizeof(V));
+  }
+}
+
+#ifdef __cpp_lib_bitops
+template<typename T, int n>
+void std_rotl_loop(const T* s, T* d, size_t len)
+{
+  for (size_t i = 0; i < len; ++i) {
+    d[i] = std::rotl(s[i], n);
+  }
+}
+#endif
+
+#ifdef BENCH_HAVE_BUILTIN_ROTATELEFT
+static inline uint8_t builtin_rotl(uint8_t v, int n)
+{
+  return __builtin_rotateleft8(v, n);
+}
+
+static inline uint16_t builtin_rotl(uint16_t v, int n)
+{
+  return __builtin_rotateleft16(v, n);
+}
+
+static inline uint32_t builtin_rotl(uint32_t v, int n)
+{
+  return __builtin_rotateleft32(v, n);
+}
+
+static inline uint64_t builtin_rotl(uint64_t v, int n)
+{
+  return __builtin_rotateleft64(v, n);
+}
+
+template<typename T, int n>
+void builtin_rotl_loop(const T* s, T* d, size_t len)
+{
+  for (size_t i = 0; i < len; ++i) {
+    d[i] = builtin_rotl(s[i], n);
+  }
+}
+#endif
+
+} // namespace bench_baselines_detail
+
+// Streaming, latency and throughput cases per shift count for each
+// baseline, named prefix + "/std_rotl", "/builtin_rotl" and "/vector_ext".
+template<typename T>
+void bench_add_compiler_baselines(bench_registry* bench, const std::string& prefix)
+{
+  using namespace bench_baselines_detail;
+  static const int kBits = 8 * sizeof(T);
+  typedef typename vec<T>::type V;
+
+#ifdef __cpp_lib_bitops
+  bench_add_shifts<T>(bench, prefix + "/std_rotl", [](auto n, const T* s, T* d, size_t len) {
+    std_rotl_loop<T, decltype(n)::value>(s, d, len);
+  });
+  bench_add_chains<T, kBits>(bench, prefix + "/std_rotl", [](auto n, T v) {
+    return std::rotl(v, decltype(n)::value);
+  });
+#endif
+#ifdef BENCH_HAVE_BUILTIN_ROTATELEFT
+  bench_add_shifts<T>(bench, prefix + "/builtin_rotl", [](auto n, const T* s, T* d, size_t len) {
+    builtin_rotl_loop<T, decltype(n)::value>(s, d, len);
+  });
+  bench_add_chains<T, kBits>(bench, prefix + "/builtin_rotl", [](auto n, T v) {
+    return builtin_rotl(v, decltype(n)::value);
+  });
+#endif
+  bench_add_shifts<T>(bench, prefix + "/vector_ext", [](auto n, const T* s, T* d, size_t len) {
+    vector_loop<T, decltype(n)::value>(s, d, len);
+  });
+  bench_add_chains<V, kBits>(bench, prefix + "/vector_ext", [](auto n, V v) {
+    return vector_rotl<T, decltype(n)::value>(v);
+  });
+}
+
+#endif /* BENCH_BASELINES_H */
@@ -0,0 +1,175 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench_counters.h"
+
+#ifdef __linux__
+
+namespace {
+
+struct event_spec {
+  const char* name;
+  uint32_t type;
+  uint64_t config;
+};
+
+constexpr uint64_t cache_event(uint64_t cache, uint64_t op, uint64_t result)
+{
+  return cache | (op << 8) | (result << 16);
+}
+
+// Cycles first: it leads the group. Where a name is listed twice the first
+// event that opens is used.
+const event_spec kEvents[] = {
+  { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+  { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+  { "l1d_misses", PERF_TYPE_HW_CACHE,
+    cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+  { "llc_misses", PERF_TYPE_HW_CACHE,
+    cache_event(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+  { "llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+  { "branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+int open_event(const event_spec& e, int group_fd)
+{
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = e.type;
+  attr.config = e.config;
+  attr.disabled = group_fd < 0;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+} // namespace
+
+bench_counters::bench_counters()
+{
+  for (const auto& e : kEvents) {
+    bool have = false;
+    for (const auto& o : events_) {
+      have |= o.name == e.name;
+    }
+    if (have) {
+      continue;
+    }
+    const auto leader = events_.empty() ? -1 : events_[0].fd;
+    const auto fd = open_event(e, leader);
+    if (fd >= 0) {
+      events_.push_back({ e.name, fd });
+    } else if (leader < 0) {
+      error_ = std::string("perf_event_open: ") + strerror(errno);
+      return;
+    }
+  }
+}
+
+bench_counters::~bench_counters()
+{
+  for (const auto& e : events_) {
+    close(e.fd);
+  }
+}
+
+void bench_counters::start()
+{
+  if (available()) {
+    ioctl(events_[0].fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(events_[0].fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+}
+
+void bench_counters::stop()
+{
+  if (available()) {
+    ioctl(events_[0].fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+  }
+}
+
+std::vector<std::pair<std::string, double>> bench_counters::read() const
+{
+  std::vector<std::pair<std::string, double>> counts;
+  if (!available()) {
+    return counts;
+  }
+  // nr, time_enabled, time_running, then one value per event.
+  std::vector<uint64_t> buf(3 + events_.size());
+  const auto bytes = static_cast<ssize_t>(buf.size() * sizeof(uint64_t));
+  if (::read(events_[0].fd, buf.data(), bytes) != bytes || buf[0] != events_.size() || buf[2] == 0) {
+    return counts;
+  }
+  const auto scale = static_cast<double>(buf[1]) / buf[2];
+  for (size_t i = 0; i < events_.size(); ++i) {
+    counts.push_back({ events_[i].name, buf[3 + i] * scale });
+  }
+  return counts;
+}
+
+#else
+
+bench_counters::bench_counters() : error_("perf_event_open is only available on Linux")
+{
+}
+
+bench_counters::~bench_counters()
+{
+}
+
+void bench_counters::start()
+{
+}
+
+void bench_counters::stop()
+{
+}
+
+std::vector<std::pair<std::string, double>> bench_counters::read() const
+{
+  return {};
+}
+
+#endif
+
+std::vector<std::pair<std::string, double>> bench_counters::per_elem(uint64_t calls, size_t elems) const
+{
+  std::vector<std::pair<std::string, double>> out;
+  const auto n = static_cast<double>(calls) * (elems ? elems : 1);
+  double cycles = 0;
+  double insns = 0;
+  for (const auto& c : read()) {
+    if (c.first == "cycles") {
+      cycles = c.second;
+      out.push_back({ "cycles/elem", c.second / n });
+    } else if (c.first == "instructions") {
+      insns = c.second;
+      out.push_back({ "insns/elem", c.second / n });
+    } else if (c.first == "l1d_misses") {
+      out.push_back({ "l1d_miss/elem", c.second / n });
+    } else if (c.first == "llc_misses") {
+      out.push_back({ "llc_miss/elem", c.second / n });
+    } else if (c.first == "branch_misses") {
+      out.push_back({ "br_miss/elem", c.second / n });
+    }
+  }
+  if (cycles > 0 && insns > 0) {
+    out.push_back({ "ipc", insns / cycles });
+  }
+  return out;
+}
@@ -0,0 +1,55 @@
+#ifndef BENCH_COUNTERS_H
+#define BENCH_COUNTERS_H
+
+#include <cstdint>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Hardware counters for the benchmark runner, read with perf_event_open for
+// the calling thread in user space only. The events are opened as one group
+// led by cycles; events the kernel or the PMU do not support are dropped,
+// and when cycles cannot be opened at all (no PMU in a container or VM,
+// perf_event_paranoid above 2) the runner reports wall-clock time only.
+
+class bench_counters {
+public:
+  bench_counters();
+  ~bench_counters();
+
+  bench_counters(const bench_counters&) = delete;
+  bench_counters& operator=(const bench_counters&) = delete;
+
+  bool available() const
+  {
+    return !events_.empty();
+  }
+
+  // Why no counters could be opened.
+  const std::string& error() const
+  {
+    return error_;
+  }
+
+  void start();
+  void stop();
+
+  // Counts between start() and stop() as (name, value) pairs, scaled up
+  // when the kernel multiplexed the group.
+  std::vector<std::pair<std::string, double>> read() const;
+
+  // cycles/elem, insns/elem, ipc and misses/elem for calls * elems elements.
+  std::vector<std::pair<std::string, double>> per_elem(uint64_t calls, size_t elems) const;
+
+private:
+  struct event {
+    std::string name;
+    int fd;
+  };
+
+  std::vector<event> events_;
+  std::string error_;
+};
+
+#endif /* BENCH_COUNTERS_H */
@@ -6,49 +6,130 @@
 #include <arm_neon.h>
 
 #include <vector>
-#include <random>
-#include <chrono>
 
+#include "bench.h"
 #include "neon_circular_shift.h"
+#include "neon_circular_shift_stats.h"
+#include "neon_circular_shift_tune.h"
 
 void test_u8();
-void perf_u8();
+void perf_u8(bench_registry* bench);
 void test_u16();
-void perf_u16();
+void perf_u16(bench_registry* bench);
 void test_u32();
-void perf_u32();
+void perf_u32(bench_registry* bench);
 void test_u64();
-void perf_u64();
+void perf_u64(bench_registry* bench);
 
 void test_q_u8();
-void perf_q_u8();
+void perf_q_u8(bench_registry* bench);
 void test_q_u16();
-void perf_q_u16();
+void perf_q_u16(bench_registry* bench);
 void test_q_u32();
-void perf_q_u32();
+void perf_q_u32(bench_registry* bench);
 void test_q_u64();
-void perf_q_u64();
+void perf_q_u64(bench_registry* bench);
+
+void test_xoshiro();
+void perf_xoshiro(bench_registry* bench);
+void test_counter_rng();
+void perf_counter_rng(bench_registry* bench);
+void test_speck();
+void perf_speck(bench_registry* bench);
+void test_ascon();
+void perf_ascon(bench_registry* bench);
+void test_buzhash();
+void perf_buzhash(bench_registry* bench);
+void test_lbp();
+void perf_lbp(bench_registry* bench);
+void test_bitcorr();
+void perf_bitcorr(bench_registry* bench);
+void test_qc_gf2();
+void perf_qc_gf2(bench_registry* bench);
+void test_bloom();
+void perf_bloom(bench_registry* bench);
+void test_roll();
+void perf_roll(bench_registry* bench);
+void test_bulk();
+void perf_bulk(bench_registry* bench);
+void test_expr();
+void perf_expr(bench_registry* bench);
+void test_pipeline();
+void perf_pipeline(bench_registry* bench);
+void test_arena();
+void perf_arena(bench_registry* bench);
+void test_baselines();
 
 int main(const int argc, const char* argv[])
 {
-  test_u8();
-  perf_u8();
-  test_u16();
-  perf_u16();
-  test_u32();
-  perf_u32();
-  test_u64();
-  perf_u64();
-
-  test_q_u8();
-  perf_q_u8();
-  test_q_u16();
-  perf_q_u16();
-  test_q_u32();
-  perf_q_u32();
-  test_q_u64();
-  perf_q_u64();
-
-  return 0;
-}
+  bench_options opt;
+  if (!bench_parse_args(argc, argv, &opt)) {
+    return 1;
+  }
+
+  if (opt.test && !opt.list) {
+    test_u8();
+    test_u16();
+    test_u32();
+    test_u64();
+    test_q_u8();
+    test_q_u16();
+    test_q_u32();
+    test_q_u64();
+    test_xoshiro();
+    test_counter_rng();
+    test_speck();
+    test_ascon();
+    test_buzhash();
+    test_lbp();
+    test_bitcorr();
+    test_qc_gf2();
+    test_bloom();
+    test_roll();
+    test_bulk();
+    test_expr();
+    test_pipeline();
+    test_arena();
+    test_baselines();
+  }
 
+  if (!opt.tune.empty() && !opt.list) {
+    shlc_bulk_autotune(shlc_tune_options(), stdout);
+    if (!shlc_bulk_save_tuning(opt.tune)) {
+      fprintf(stderr, "cannot write %s\n", opt.tune.c_str());
+      return 1;
+    }
+  }
+
+  if (!opt.bench && !opt.list) {
+    return 0;
+  }
+  bench_registry bench;
+  perf_u8(&bench);
+  perf_u16(&bench);
+  perf_u32(&bench);
+  perf_u64(&bench);
+  perf_q_u8(&bench);
+  perf_q_u16(&bench);
+  perf_q_u32(&bench);
+  perf_q_u64(&bench);
+  perf_xoshiro(&bench);
+  perf_counter_rng(&bench);
+  perf_speck(&bench);
+  perf_ascon(&bench);
+  perf_buzhash(&bench);
+  perf_lbp(&bench);
+  perf_bitcorr(&bench);
+  perf_qc_gf2(&bench);
+  perf_bloom(&bench);
+  perf_roll(&bench);
+  perf_bulk(&bench);
+  perf_expr(&bench);
+  perf_pipeline(&bench);
+  perf_arena(&bench);
+  const auto ret = bench_run_all(bench, opt);
+  if (opt.stats) {
+    fputs(opt.format == "json" ? shlc_bulk_stats_json().c_str() : shlc_bulk_stats_text().c_str(), stderr);
+  }
+  return ret;
+}
@@ -0,0 +1,51 @@
+// Inner loops of the rotation kernels for llvm-mca. Not part of the program:
+// mca_report.sh compiles this file with -S for each core and feeds the
+// marked regions to llvm-mca.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "neon_circular_shift.h"
+
+#if defined(__aarch64__)
+#define MCA_COMMENT "#"
+#else
+#define MCA_COMMENT "@"
+#endif
+
+// One region per kernel, named like its benchmark case and shift count
+// (u32/q/neon:5), around one iteration of the loop. Build without unrolling
+// so that each region appears once.
+#define MCA_KERNEL(fn, region, T, V, load, store, rotate, n)    \
+  extern "C" void fn(const T* s, T* d, size_t len)              \
+  {                                                             \
+    for (size_t i = 0; i < len; i += sizeof(V) / sizeof(T)) {   \
+      __asm__ volatile(MCA_COMMENT " LLVM-MCA-BEGIN " region);  \
+      store(d + i, rotate<n>(load(s + i)));                     \
+      __asm__ volatile(MCA_COMMENT " LLVM-MCA-END " region);    \
+    }                                                           \
+  }
+
+// Each width at a generic shift count, at half the width (VREV where the
+// header has one) and at a multiple of 8 (TBL byte permutation on AArch64).
+MCA_KERNEL(mca_d_u8_3, "u8/d/neon:3", uint8_t, uint8x8_t, vld1_u8, vst1_u8, vshlc_n_u8, 3)
+MCA_KERNEL(mca_d_u8_4, "u8/d/neon:4", uint8_t, uint8x8_t, vld1_u8, vst1_u8, vshlc_n_u8, 4)
+MCA_KERNEL(mca_d_u16_3, "u16/d/neon:3", uint16_t, uint16x4_t, vld1_u16, vst1_u16, vshlc_n_u16, 3)
+MCA_KERNEL(mca_d_u16_8, "u16/d/neon:8", uint16_t, uint16x4_t, vld1_u16, vst1_u16, vshlc_n_u16, 8)
+MCA_KERNEL(mca_d_u32_5, "u32/d/neon:5", uint32_t, uint32x2_t, vld1_u32, vst1_u32, vshlc_n_u32, 5)
+MCA_KERNEL(mca_d_u32_8, "u32/d/neon:8", uint32_t, uint32x2_t, vld1_u32, vst1_u32, vshlc_n_u32, 8)
+MCA_KERNEL(mca_d_u32_16, "u32/d/neon:16", uint32_t, uint32x2_t, vld1_u32, vst1_u32, vshlc_n_u32, 16)
+MCA_KERNEL(mca_d_u64_5, "u64/d/neon:5", uint64_t, uint64x1_t, vld1_u64, vst1_u64, vshlc_n_u64, 5)
+MCA_KERNEL(mca_d_u64_8, "u64/d/neon:8", uint64_t, uint64x1_t, vld1_u64, vst1_u64, vshlc_n_u64, 8)
+MCA_KERNEL(mca_d_u64_32, "u64/d/neon:32", uint64_t, uint64x1_t, vld1_u64, vst1_u64, vshlc_n_u64, 32)
+
+MCA_KERNEL(mca_q_u8_3, "u8/q/neon:3", uint8_t, uint8x16_t, vld1q_u8, vst1q_u8, vshlcq_n_u8, 3)
+MCA_KERNEL(mca_q_u8_4, "u8/q/neon:4", uint8_t, uint8x16_t, vld1q_u8, vst1q_u8, vshlcq_n_u8, 4)
+MCA_KERNEL(mca_q_u16_3, "u16/q/neon:3", uint16_t, uint16x8_t, vld1q_u16, vst1q_u16, vshlcq_n_u16, 3)
+MCA_KERNEL(mca_q_u16_8, "u16/q/neon:8", uint16_t, uint16x8_t, vld1q_u16, vst1q_u16, vshlcq_n_u16, 8)
+MCA_KERNEL(mca_q_u32_5, "u32/q/neon:5", uint32_t, uint32x4_t, vld1q_u32, vst1q_u32, vshlcq_n_u32, 5)
+MCA_KERNEL(mca_q_u32_8, "u32/q/neon:8", uint32_t, uint32x4_t, vld1q_u32, vst1q_u32, vshlcq_n_u32, 8)
+MCA_KERNEL(mca_q_u32_16, "u32/q/neon:16", uint32_t, uint32x4_t, vld1q_u32, vst1q_u32, vshlcq_n_u32, 16)
+MCA_KERNEL(mca_q_u64_5, "u64/q/neon:5", uint64_t, uint64x2_t, vld1q_u64, vst1q_u64, vshlcq_n_u64, 5)
+MCA_KERNEL(mca_q_u64_8, "u64/q/neon:8", uint64_t, uint64x2_t, vld1q_u64, vst1q_u64, vshlcq_n_u64, 8)
+MCA_KERNEL(mca_q_u64_32, "u64/q/neon:32", uint64_t, uint64x2_t, vld1q_u64, vst1q_u64, vshlcq_n_u64, 32)
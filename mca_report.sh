@@ -0,0 +1,87 @@
+#!/bin/sh -eu
+#
+# Predicted throughput of the rotation kernels from llvm-mca, per core:
+#
+#   ./mca_report.sh [OUT.md]
+#
+# Every region of mca_kernels.cpp is compiled for each of CPUS and run
+# through llvm-mca with the same -mcpu. The table gives cycles per loop
+# iteration (one vector), llvm-mca's block reciprocal throughput, uops and
+# IPC, and the two most used resources per iteration. "model" is the
+# scheduling model llvm-mca picked; where a core has none of its own it falls
+# back to a related one, and the numbers are only as good as that model.
+#
+# CXX (default clang++) must target TARGET (default aarch64-linux-gnu): LLVM
+# has no ARMv7 scheduling models for these cores. For a GCC cross compiler,
+# set CXX=aarch64-linux-gnu-g++ CXXFLAGS=.
+
+SRC=$(dirname "$0")/mca_kernels.cpp
+OUT=${1:-/dev/stdout}
+CXX=${CXX:-clang++}
+LLVM_MCA=${LLVM_MCA:-llvm-mca}
+TARGET=${TARGET:-aarch64-linux-gnu}
+CXXFLAGS=${CXXFLAGS---target=$TARGET}
+CPUS=${CPUS:-cortex-a53 cortex-a72 cortex-a76 neoverse-n1}
+
+ASM=$(mktemp)
+ROWS=$(mktemp)
+trap 'rm -f "$ASM" "$ROWS"' EXIT
+
+for CPU in $CPUS; do
+  # shellcheck disable=SC2086
+  "$CXX" $CXXFLAGS -mcpu="$CPU" -std=c++17 -O3 -fno-unroll-loops -S "$SRC" -o "$ASM"
+  "$LLVM_MCA" -mtriple="$TARGET" -mcpu="$CPU" -iterations=100 "$ASM" 2>/dev/null |
+  awk -v cpu="$CPU" '
+    function width(name) {
+      sub(/\/.*/, "", name)
+      return substr(name, 2) + 0
+    }
+    function class(name, w, n) {
+      n = name
+      sub(/.*:/, "", n)
+      n += 0
+      return n == w / 2 ? "half" : n % 8 == 0 ? "byte" : "generic"
+    }
+    /Code Region - / { region = $0; sub(/.*Code Region - /, "", region); split("", unit); nunits = 0 }
+    /^Iterations:/ { iterations = $2 }
+    /^Total Cycles:/ { cycles = $3 }
+    /^Total uOps:/ { uops = $3 }
+    /^IPC:/ { ipc = $2 }
+    /^Block RThroughput:/ { rthroughput = $3 }
+    /^Resources:/ { mode = "units"; next }
+    mode == "units" && /^\[/ { unit[$1] = $3; next }
+    mode == "units" { mode = "" }
+    /^Resource pressure per iteration:/ { mode = "header"; next }
+    mode == "header" { n = split($0, idx); mode = "values"; next }
+    mode == "values" {
+      mode = ""
+      split($0, val)
+      model = unit[idx[1]]
+      sub(/Unit.*/, "", model)
+      # The two busiest resources, once per name.
+      first = ""; second = ""; p1 = 0; p2 = 0
+      for (i = 1; i <= n; ++i) {
+        p = val[i] == "-" ? 0 : val[i] + 0
+        name = unit[idx[i]]
+        if (name == first) {
+          if (p > p1) p1 = p
+        } else if (p > p1) {
+          second = first; p2 = p1; first = name; p1 = p
+        } else if (name != second && p > p2) {
+          second = name; p2 = p
+        }
+      }
+      pressure = first == "" ? "-" : sprintf("%s %.2f", first, p1)
+      if (second != "") pressure = pressure sprintf(", %s %.2f", second, p2)
+      printf "| %s | %s | %s | %s | %.2f | %s | %.2f | %s | %s |\n",
+        region, class(region, width(region)), cpu, model, cycles / iterations, rthroughput,
+        uops / iterations, ipc, pressure
+    }
+  ' >> "$ROWS"
+done
+
+{
+  echo "| kernel | class | cpu | model | cycles/iter | rthroughput | uops/iter | ipc | pressure/iter |"
+  echo "|:---|:---|:---|:---|---:|---:|---:|---:|:---|"
+  sort -s -t '|' -k 2,2 "$ROWS"
+} > "$OUT"
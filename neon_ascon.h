@@ -0,0 +1,400 @@
+#ifndef NEON_ASCON_H
+#define NEON_ASCON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <arm_neon.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "neon_circular_shift.h"
+
+// Ascon-128 AEAD and Ascon-Hash (Ascon v1.2), two independent messages per
+// Q register: lane 0 of every state word belongs to one message and lane 1
+// to the other.
+// The bulk APIs pair messages of similar length. A pair runs in lockstep
+// through its permutations; when one message has fewer blocks its lane is
+// masked until the other catches up, so any pair is correct, and similar
+// lengths keep the masked work small.
+
+struct neon_ascon_aead_job {
+  const uint8_t* nonce;    // 16 bytes
+  const uint8_t* ad;
+  size_t ad_len;
+  const uint8_t* in;       // plaintext for seal, ciphertext for open
+  size_t len;
+  uint8_t* out;            // len bytes
+  uint8_t* tag;            // 16 bytes: written by seal, checked by open
+};
+
+struct neon_ascon_hash_job {
+  const uint8_t* msg;
+  size_t len;
+  uint8_t* digest;         // 32 bytes
+};
+
+namespace neon_ascon_detail {
+
+static inline uint64_t load_be(const uint8_t* p, size_t n)
+{
+  uint64_t v = 0;
+  for (size_t i = 0; i < 8; ++i) {
+    v = (v << 8) | (i < n ? p[i] : 0);
+  }
+  return v;
+}
+
+static inline void store_be(uint64_t v, uint8_t* p, size_t n)
+{
+  for (size_t i = 0; i < n; ++i) {
+    p[i] = static_cast<uint8_t>(v >> (56 - 8 * i));
+  }
+}
+
+static inline uint64_t pad(size_t n)
+{
+  return 0x80ULL << (56 - 8 * n);
+}
+
+// The linear layer rotates right; ror(x, r) == vshlcq_n_u64<64 - r>(x).
+static inline void round(uint64x2_t* x, uint64_t c)
+{
+  x[2] = veorq_u64(x[2], vdupq_n_u64(c));
+  x[0] = veorq_u64(x[0], x[4]);
+  x[4] = veorq_u64(x[4], x[3]);
+  x[2] = veorq_u64(x[2], x[1]);
+  const auto t0 = vbicq_u64(x[1], x[0]);
+  const auto t1 = vbicq_u64(x[2], x[1]);
+  const auto t2 = vbicq_u64(x[3], x[2]);
+  const auto t3 = vbicq_u64(x[4], x[3]);
+  const auto t4 = vbicq_u64(x[0], x[4]);
+  x[0] = veorq_u64(x[0], t1);
+  x[1] = veorq_u64(x[1], t2);
+  x[2] = veorq_u64(x[2], t3);
+  x[3] = veorq_u64(x[3], t4);
+  x[4] = veorq_u64(x[4], t0);
+  x[1] = veorq_u64(x[1], x[0]);
+  x[0] = veorq_u64(x[0], x[4]);
+  x[3] = veorq_u64(x[3], x[2]);
+  x[2] = vreinterpretq_u64_u32(vmvnq_u32(vreinterpretq_u32_u64(x[2])));
+  x[0] = veorq_u64(x[0], veorq_u64(vshlcq_n_u64<45>(x[0]), vshlcq_n_u64<36>(x[0])));
+  x[1] = veorq_u64(x[1], veorq_u64(vshlcq_n_u64<3>(x[1]), vshlcq_n_u64<25>(x[1])));
+  x[2] = veorq_u64(x[2], veorq_u64(vshlcq_n_u64<63>(x[2]), vshlcq_n_u64<58>(x[2])));
+  x[3] = veorq_u64(x[3], veorq_u64(vshlcq_n_u64<54>(x[3]), vshlcq_n_u64<47>(x[3])));
+  x[4] = veorq_u64(x[4], veorq_u64(vshlcq_n_u64<57>(x[4]), vshlcq_n_u64<23>(x[4])));
+}
+
+static inline void permutation(uint64x2_t* x, int rounds)
+{
+  for (int r = 12 - rounds; r < 12; ++r) {
+    round(x, ((0xfULL - r) << 4) | r);
+  }
+}
+
+// Permutation for a pair where only the lanes set in `active` may change.
+static inline void permutation_masked(uint64x2_t* x, int rounds, const bool* active)
+{
+  if (active[0] && active[1]) {
+    permutation(x, rounds);
+    return;
+  }
+  const uint64_t m[2] = { active[0] ? ~0ULL : 0, active[1] ? ~0ULL : 0 };
+  const auto mask = vld1q_u64(m);
+  uint64x2_t old[5];
+  memcpy(old, x, sizeof(old));
+  permutation(x, rounds);
+  for (int w = 0; w < 5; ++w) {
+    x[w] = vbslq_u64(mask, x[w], old[w]);
+  }
+}
+
+static inline uint64x2_t make_pair(uint64_t a, uint64_t b)
+{
+  const uint64_t v[2] = { a, b };
+  return vld1q_u64(v);
+}
+
+// Per-message cursor over the blocks between the permutations.
+class aead_lane {
+public:
+  aead_lane() : job_(nullptr), decrypt_(false), ad_blocks_(0), pt_blocks_(0) {}
+
+  aead_lane(const neon_ascon_aead_job* job, bool decrypt)
+    : job_(job), decrypt_(decrypt),
+      ad_blocks_(job->ad_len ? job->ad_len / 8 + 1 : 0), pt_blocks_(job->len / 8) {}
+
+  size_t events() const
+  {
+    return ad_blocks_ + pt_blocks_;
+  }
+
+  const neon_ascon_aead_job* job() const
+  {
+    return job_;
+  }
+
+  bool decrypt() const
+  {
+    return decrypt_;
+  }
+
+  // Data to absorb before permutation k; x0 is the current rate word.
+  void event(size_t k, uint64_t x0, uint64_t* x0_xor, uint64_t* x4_xor) const
+  {
+    *x4_xor = 0;
+    if (k < ad_blocks_) {
+      const auto off = 8 * k;
+      const auto n = std::min<size_t>(8, job_->ad_len - off);
+      *x0_xor = load_be(job_->ad + off, n) | (n < 8 ? pad(n) : 0);
+      return;
+    }
+    if (k == ad_blocks_) {
+      *x4_xor = 1;
+    }
+    const auto off = 8 * (k - ad_blocks_);
+    const auto in = load_be(job_->in + off, 8);
+    // Decryption absorbs the recovered plaintext, which leaves the
+    // ciphertext in the rate word exactly as encryption does.
+    *x0_xor = decrypt_ ? x0 ^ in : in;
+    store_be(x0 ^ in, job_->out + off, 8);
+  }
+
+  // Last partial block (possibly empty) after all permutations.
+  void tail(uint64_t x0, uint64_t* x0_xor, uint64_t* x4_xor) const
+  {
+    *x4_xor = pt_blocks_ == 0 ? 1 : 0;
+    const auto off = 8 * pt_blocks_;
+    const auto n = job_->len - off;
+    const auto in = load_be(job_->in + off, n);
+    if (decrypt_) {
+      const auto mask = n ? ~0ULL << (64 - 8 * n) : 0;
+      const auto p = (x0 ^ in) & mask;
+      *x0_xor = p | pad(n);
+      store_be(p, job_->out + off, n);
+    } else {
+      *x0_xor = in | pad(n);
+      store_be(x0 ^ *x0_xor, job_->out + off, n);
+    }
+  }
+
+private:
+  const neon_ascon_aead_job* job_;
+  bool decrypt_;
+  size_t ad_blocks_;
+  size_t pt_blocks_;
+};
+
+} // namespace neon_ascon_detail
+
+class neon_ascon128 {
+public:
+  static const int kKeyBytes = 16;
+  static const int kNonceBytes = 16;
+  static const int kTagBytes = 16;
+
+  explicit neon_ascon128(const uint8_t* key)
+    : k0_(neon_ascon_detail::load_be(key, 8)), k1_(neon_ascon_detail::load_be(key + 8, 8))
+  {
+  }
+
+  void seal(const uint8_t* nonce, const uint8_t* ad, size_t ad_len,
+            const uint8_t* pt, size_t len, uint8_t* ct, uint8_t* tag) const
+  {
+    const neon_ascon_aead_job job = { nonce, ad, ad_len, pt, len, ct, tag };
+    seal(&job, 1);
+  }
+
+  bool open(const uint8_t* nonce, const uint8_t* ad, size_t ad_len,
+            const uint8_t* ct, size_t len, uint8_t* pt, const uint8_t* tag) const
+  {
+    const neon_ascon_aead_job job = { nonce, ad, ad_len, ct, len, pt, const_cast<uint8_t*>(tag) };
+    bool ok = false;
+    open(&job, 1, &ok);
+    return ok;
+  }
+
+  void seal(const neon_ascon_aead_job* jobs, size_t n) const
+  {
+    run(jobs, n, false, nullptr);
+  }
+
+  // ok[i] tells whether jobs[i] was authentic; the output of a forged
+  // message is zeroed. Returns the number of authentic messages.
+  size_t open(const neon_ascon_aead_job* jobs, size_t n, bool* ok) const
+  {
+    return run(jobs, n, true, ok);
+  }
+
+private:
+  size_t run(const neon_ascon_aead_job* jobs, size_t n, bool decrypt, bool* ok) const
+  {
+    std::vector<size_t> order(n);
+    for (size_t i = 0; i < n; ++i) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [jobs](size_t a, size_t b) {
+      return jobs[a].ad_len / 8 + jobs[a].len / 8 < jobs[b].ad_len / 8 + jobs[b].len / 8;
+    });
+    size_t authentic = 0;
+    for (size_t i = 0; i < n; i += 2) {
+      neon_ascon_detail::aead_lane lanes[2];
+      lanes[0] = neon_ascon_detail::aead_lane(&jobs[order[i]], decrypt);
+      if (i + 1 < n) {
+        lanes[1] = neon_ascon_detail::aead_lane(&jobs[order[i + 1]], decrypt);
+      }
+      bool pair_ok[2];
+      run_pair(lanes, pair_ok);
+      for (int l = 0; l < 2 && i + l < n; ++l) {
+        if (ok) {
+          ok[order[i + l]] = pair_ok[l];
+        }
+        authentic += pair_ok[l];
+      }
+    }
+    return authentic;
+  }
+
+  void run_pair(const neon_ascon_detail::aead_lane* lanes, bool* ok) const
+  {
+    using namespace neon_ascon_detail;
+    const bool used[2] = { true, lanes[1].job() != nullptr };
+    const neon_ascon_aead_job* jobs[2] = { lanes[0].job(), used[1] ? lanes[1].job() : lanes[0].job() };
+
+    uint64x2_t x[5];
+    x[0] = vdupq_n_u64(0x80400c0600000000ULL);
+    x[1] = vdupq_n_u64(k0_);
+    x[2] = vdupq_n_u64(k1_);
+    x[3] = make_pair(load_be(jobs[0]->nonce, 8), load_be(jobs[1]->nonce, 8));
+    x[4] = make_pair(load_be(jobs[0]->nonce + 8, 8), load_be(jobs[1]->nonce + 8, 8));
+    permutation(x, 12);
+    x[3] = veorq_u64(x[3], vdupq_n_u64(k0_));
+    x[4] = veorq_u64(x[4], vdupq_n_u64(k1_));
+
+    const size_t events[2] = { lanes[0].events(), used[1] ? lanes[1].events() : 0 };
+    const auto total = std::max(events[0], events[1]);
+    uint64_t x0[2], x0_xor[2], x4_xor[2];
+    for (size_t k = 0; k < total; ++k) {
+      vst1q_u64(x0, x[0]);
+      bool active[2];
+      for (int l = 0; l < 2; ++l) {
+        active[l] = k < events[l];
+        x0_xor[l] = x4_xor[l] = 0;
+        if (active[l]) {
+          lanes[l].event(k, x0[l], &x0_xor[l], &x4_xor[l]);
+        }
+      }
+      x[0] = veorq_u64(x[0], vld1q_u64(x0_xor));
+      x[4] = veorq_u64(x[4], vld1q_u64(x4_xor));
+      permutation_masked(x, 6, active);
+    }
+
+    vst1q_u64(x0, x[0]);
+    for (int l = 0; l < 2; ++l) {
+      x0_xor[l] = x4_xor[l] = 0;
+      if (used[l]) {
+        lanes[l].tail(x0[l], &x0_xor[l], &x4_xor[l]);
+      }
+    }
+    x[0] = veorq_u64(x[0], vld1q_u64(x0_xor));
+    x[4] = veorq_u64(x[4], vld1q_u64(x4_xor));
+    x[1] = veorq_u64(x[1], vdupq_n_u64(k0_));
+    x[2] = veorq_u64(x[2], vdupq_n_u64(k1_));
+    permutation(x, 12);
+    x[3] = veorq_u64(x[3], vdupq_n_u64(k0_));
+    x[4] = veorq_u64(x[4], vdupq_n_u64(k1_));
+
+    uint64_t t0[2], t1[2];
+    vst1q_u64(t0, x[3]);
+    vst1q_u64(t1, x[4]);
+    for (int l = 0; l < 2; ++l) {
+      ok[l] = false;
+      if (!used[l]) {
+        continue;
+      }
+      const auto job = lanes[l].job();
+      uint8_t tag[kTagBytes];
+      store_be(t0[l], tag, 8);
+      store_be(t1[l], tag + 8, 8);
+      if (!lanes[l].decrypt()) {
+        memcpy(job->tag, tag, kTagBytes);
+        ok[l] = true;
+        continue;
+      }
+      uint8_t diff = 0;
+      for (int i = 0; i < kTagBytes; ++i) {
+        diff |= tag[i] ^ job->tag[i];
+      }
+      ok[l] = diff == 0;
+      if (!ok[l]) {
+        memset(job->out, 0, job->len);
+      }
+    }
+  }
+
+  uint64_t k0_;
+  uint64_t k1_;
+};
+
+// Ascon-Hash: 256-bit digests, two messages per Q register.
+static inline void neon_ascon_hash(const neon_ascon_hash_job* jobs, size_t n)
+{
+  using namespace neon_ascon_detail;
+  // p^12 applied to the IV 0x00400c0000000100 || 0^256.
+  static const uint64_t kInit[5] = {
+    0xee9398aadb67f03dULL, 0x8bb21831c60f1002ULL, 0xb48a92db98d5da62ULL,
+    0x43189921b8f8e3e8ULL, 0x348fa5c9d525e140ULL
+  };
+  std::vector<size_t> order(n);
+  for (size_t i = 0; i < n; ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [jobs](size_t a, size_t b) {
+    return jobs[a].len < jobs[b].len;
+  });
+  for (size_t i = 0; i < n; i += 2) {
+    const bool used[2] = { true, i + 1 < n };
+    const neon_ascon_hash_job* pair[2] = { &jobs[order[i]], &jobs[order[used[1] ? i + 1 : i]] };
+    const size_t blocks[2] = { pair[0]->len / 8, used[1] ? pair[1]->len / 8 : 0 };
+
+    uint64x2_t x[5];
+    for (int w = 0; w < 5; ++w) {
+      x[w] = vdupq_n_u64(kInit[w]);
+    }
+    uint64_t m[2];
+    for (size_t k = 0; k < std::max(blocks[0], blocks[1]); ++k) {
+      bool active[2];
+      for (int l = 0; l < 2; ++l) {
+        active[l] = k < blocks[l];
+        m[l] = active[l] ? load_be(pair[l]->msg + 8 * k, 8) : 0;
+      }
+      x[0] = veorq_u64(x[0], vld1q_u64(m));
+      permutation_masked(x, 12, active);
+    }
+    for (int l = 0; l < 2; ++l) {
+      const auto off = 8 * blocks[l];
+      const auto rest = used[l] ? pair[l]->len - off : 0;
+      m[l] = used[l] ? load_be(pair[l]->msg + off, rest) | pad(rest) : 0;
+    }
+    x[0] = veorq_u64(x[0], vld1q_u64(m));
+    for (int k = 0; k < 4; ++k) {
+      permutation(x, 12);
+      vst1q_u64(m, x[0]);
+      for (int l = 0; l < 2; ++l) {
+        if (used[l]) {
+          store_be(m[l], pair[l]->digest + 8 * k, 8);
+        }
+      }
+    }
+  }
+}
+
+static inline void neon_ascon_hash(const uint8_t* msg, size_t len, uint8_t* digest)
+{
+  const neon_ascon_hash_job job = { msg, len, digest };
+  neon_ascon_hash(&job, 1);
+}
+
+#endif /* NEON_ASCON_H */
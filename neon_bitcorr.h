@@ -0,0 +1,206 @@
+#ifndef NEON_BITCORR_H
+#define NEON_BITCORR_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <arm_neon.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "neon_circular_shift.h"
+
+// Circular Hamming correlation of an N-bit block against every rotation of
+// an N-bit reference code, 32 <= N <= 65536:
+//   corr[s] = number of i with received[i] == reference[(i + s) mod N]
+// Bit i of a sequence is bit i % 32 of word i / 32.
+//
+// Rotation s = 32 q + b of the reference is words q, q + 1, ... of the doubled
+// reference shifted right by b bits. The 32 shifted copies are built once, so
+// each rotation is a plain XOR and popcount over aligned words, and four
+// rotations sharing b are counted per load of the received block.
+// N = 32 and N = 64 keep the rotations of the code in registers instead.
+
+namespace neon_bitcorr_detail {
+
+static inline uint32_t popcount32(uint32_t v)
+{
+  return static_cast<uint32_t>(__builtin_popcount(v));
+}
+
+static inline uint32_t sum_u16(uint16x8_t v)
+{
+  const auto s = vpaddlq_u32(vpaddlq_u16(v));
+  return static_cast<uint32_t>(vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1));
+}
+
+// dist[k] = Hamming distance between r and s + k over `words` words and the
+// bits of word `words` selected by tail_mask.
+template<int kShifts>
+static inline void hamming(const uint32_t* r, const uint32_t* s, size_t words, uint32_t tail_mask,
+                           uint32_t* dist)
+{
+  // Each u16 lane gains at most 16 per vector, so flush every 2048 vectors.
+  static const size_t kFlush = 4 * 2048;
+  uint32_t total[kShifts] = {};
+  size_t j = 0;
+  while (j + 4 <= words) {
+    uint16x8_t acc[kShifts];
+    for (int k = 0; k < kShifts; ++k) {
+      acc[k] = vdupq_n_u16(0);
+    }
+    const auto end = std::min(words & ~static_cast<size_t>(3), j + kFlush);
+    for (; j < end; j += 4) {
+      const auto rv = vld1q_u32(r + j);
+      for (int k = 0; k < kShifts; ++k) {
+        const auto x = veorq_u32(rv, vld1q_u32(s + k + j));
+        acc[k] = vpadalq_u8(acc[k], vcntq_u8(vreinterpretq_u8_u32(x)));
+      }
+    }
+    for (int k = 0; k < kShifts; ++k) {
+      total[k] += sum_u16(acc[k]);
+    }
+  }
+  for (int k = 0; k < kShifts; ++k) {
+    for (size_t i = j; i < words; ++i) {
+      total[k] += popcount32(r[i] ^ s[k + i]);
+    }
+    if (tail_mask) {
+      total[k] += popcount32((r[words] ^ s[k + words]) & tail_mask);
+    }
+    dist[k] = total[k];
+  }
+}
+
+} // namespace neon_bitcorr_detail
+
+class neon_bitcorr {
+public:
+  static const size_t kMinBits = 32;
+  static const size_t kMaxBits = 65536;
+
+  // `bits` must be within [kMinBits, kMaxBits].
+  neon_bitcorr(const uint32_t* reference, size_t bits)
+    : bits_(bits), words_(bits / 32), tail_mask_((1U << (bits % 32)) - 1)
+  {
+    const auto ref_words = (bits + 31) / 32;
+    if (bits == 32) {
+      ref64_ = reference[0];
+      return;
+    }
+    if (bits == 64) {
+      ref64_ = reference[0] | (static_cast<uint64_t>(reference[1]) << 32);
+      return;
+    }
+    // Doubled reference, periodic in `bits`.
+    stride_ = 2 * ref_words + 2;
+    std::vector<uint32_t> doubled(stride_ + 1, 0);
+    for (size_t i = 0; i < 32 * doubled.size(); ++i) {
+      const auto src = i % bits;
+      doubled[i / 32] |= ((reference[src / 32] >> (src % 32)) & 1) << (i % 32);
+    }
+    shifted_.resize(32 * stride_);
+    for (int b = 0; b < 32; ++b) {
+      auto* s = shifted_.data() + b * stride_;
+      for (size_t k = 0; k < stride_; ++k) {
+        s[k] = b ? (doubled[k] >> b) | (doubled[k + 1] << (32 - b)) : doubled[k];
+      }
+    }
+  }
+
+  size_t bits() const
+  {
+    return bits_;
+  }
+
+  // Writes corr[0 .. bits - 1] for the received block.
+  void correlate(const uint32_t* received, uint32_t* corr) const
+  {
+    if (bits_ == 32) {
+      correlate32(received, corr);
+      return;
+    }
+    if (bits_ == 64) {
+      correlate64(received, corr);
+      return;
+    }
+    for (size_t b = 0; b < 32; ++b) {
+      const auto* s = shifted_.data() + b * stride_;
+      // Rotations 32 q + b for q < q_end.
+      const auto q_end = (bits_ - b + 31) / 32;
+      size_t q = 0;
+      uint32_t dist[4];
+      for (; q + 4 <= q_end; q += 4) {
+        neon_bitcorr_detail::hamming<4>(received, s + q, words_, tail_mask_, dist);
+        for (int k = 0; k < 4; ++k) {
+          corr[32 * (q + k) + b] = static_cast<uint32_t>(bits_) - dist[k];
+        }
+      }
+      for (; q < q_end; ++q) {
+        neon_bitcorr_detail::hamming<1>(received, s + q, words_, tail_mask_, dist);
+        corr[32 * q + b] = static_cast<uint32_t>(bits_) - dist[0];
+      }
+    }
+  }
+
+private:
+  // Lanes hold rotations s .. s + 3; vshlcq_n_u32<28> moves them on by 4.
+  void correlate32(const uint32_t* received, uint32_t* corr) const
+  {
+    const auto ref = static_cast<uint32_t>(ref64_);
+    const uint32_t init[4] = {
+      ref, (ref >> 1) | (ref << 31), (ref >> 2) | (ref << 30), (ref >> 3) | (ref << 29)
+    };
+    auto v = vld1q_u32(init);
+    const auto r = vdupq_n_u32(received[0]);
+    for (int s = 0; s < 32; s += 4) {
+      const auto cnt = vpaddlq_u16(vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u32(veorq_u32(v, r)))));
+      vst1q_u32(corr + s, vsubq_u32(vdupq_n_u32(32), cnt));
+      v = vshlcq_n_u32<28>(v);
+    }
+  }
+
+  // Lanes hold rotations s and s + 1; vshlcq_n_u64<62> moves them on by 2.
+  void correlate64(const uint32_t* received, uint32_t* corr) const
+  {
+    const uint64_t init[2] = { ref64_, (ref64_ >> 1) | (ref64_ << 63) };
+    auto v = vld1q_u64(init);
+    const auto r = vdupq_n_u64(received[0] | (static_cast<uint64_t>(received[1]) << 32));
+    for (int s = 0; s < 64; s += 2) {
+      const auto cnt = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u64(veorq_u64(v, r))))));
+      corr[s] = 64 - static_cast<uint32_t>(vgetq_lane_u64(cnt, 0));
+      corr[s + 1] = 64 - static_cast<uint32_t>(vgetq_lane_u64(cnt, 1));
+      v = vshlcq_n_u64<62>(v);
+    }
+  }
+
+  size_t bits_;
+  size_t words_;
+  uint32_t tail_mask_;
+  uint64_t ref64_ = 0;
+  size_t stride_ = 0;
+  std::vector<uint32_t> shifted_;
+};
+
+// Rotation with the highest correlation; the lowest one on ties.
+static inline size_t neon_bitcorr_peak(const uint32_t* corr, size_t n)
+{
+  return static_cast<size_t>(std::max_element(corr, corr + n) - corr);
+}
+
+// The k rotations with the highest correlation, best first.
+static inline void neon_bitcorr_top_k(const uint32_t* corr, size_t n, size_t k, size_t* shifts)
+{
+  std::vector<size_t> order(n);
+  for (size_t i = 0; i < n; ++i) {
+    order[i] = i;
+  }
+  k = std::min(k, n);
+  std::partial_sort(order.begin(), order.begin() + k, order.end(), [corr](size_t a, size_t b) {
+    return corr[a] != corr[b] ? corr[a] > corr[b] : a < b;
+  });
+  std::copy(order.begin(), order.begin() + k, shifts);
+}
+
+#endif /* NEON_BITCORR_H */
@@ -0,0 +1,212 @@
+#ifndef NEON_BLOOM_H
+#define NEON_BLOOM_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <arm_neon.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "neon_circular_shift.h"
+
+// Blocked Bloom filter over 64-bit keys. Each key maps to one 64-byte block
+// (a cache line), seen as eight 64-bit words, and sets one bit in each word.
+// One 64-bit hash per key gives the block (high half) and h1 (low half);
+// with h2 = h1 * 0x9e3779b1 the k = 8 probes are
+//   p_i = rotl(h1, 4 i + 2) ^ h2,   bit p_i >> 26 of word i.
+// The probes of four keys are computed at once, one key per lane, and turned
+// into per-key block masks with two 4x4 transposes per pair of probes.
+
+namespace neon_bloom_detail {
+
+static inline uint64_t fmix64(uint64_t k)
+{
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+// Word pair i of the masks of four keys: bit (p >> 26) of a 64-bit word.
+static inline void probe(uint32x4_t p, uint32x4_t* lo, uint32x4_t* hi)
+{
+  const auto pos = vreinterpretq_s32_u32(vshrq_n_u32(p, 26));
+  const auto one = vdupq_n_u32(1);
+  // Shifts of 32 or more give zero, and so do right shifts of one.
+  *lo = vshlq_u32(one, pos);
+  *hi = vshlq_u32(one, vsubq_s32(pos, vdupq_n_s32(32)));
+}
+
+// Rows a, b, c, d (lanes = keys) to one vector per key.
+static inline void transpose(uint32x4_t* a, uint32x4_t* b, uint32x4_t* c, uint32x4_t* d)
+{
+  const auto ab = vtrnq_u32(*a, *b);
+  const auto cd = vtrnq_u32(*c, *d);
+  *a = vcombine_u32(vget_low_u32(ab.val[0]), vget_low_u32(cd.val[0]));
+  *b = vcombine_u32(vget_low_u32(ab.val[1]), vget_low_u32(cd.val[1]));
+  *c = vcombine_u32(vget_high_u32(ab.val[0]), vget_high_u32(cd.val[0]));
+  *d = vcombine_u32(vget_high_u32(ab.val[1]), vget_high_u32(cd.val[1]));
+}
+
+// mask[4 * k + j] is word group j (words 4 j .. 4 j + 3) of key k's block mask.
+static inline void masks(const uint32_t* h1, uint32x4_t* mask)
+{
+  const auto a = vld1q_u32(h1);
+  const auto b = vmulq_u32(a, vdupq_n_u32(0x9e3779b1));
+  uint32x4_t w[16];
+  probe(veorq_u32(vshlcq_n_u32<2>(a), b), &w[0], &w[1]);
+  probe(veorq_u32(vshlcq_n_u32<6>(a), b), &w[2], &w[3]);
+  probe(veorq_u32(vshlcq_n_u32<10>(a), b), &w[4], &w[5]);
+  probe(veorq_u32(vshlcq_n_u32<14>(a), b), &w[6], &w[7]);
+  probe(veorq_u32(vshlcq_n_u32<18>(a), b), &w[8], &w[9]);
+  probe(veorq_u32(vshlcq_n_u32<22>(a), b), &w[10], &w[11]);
+  probe(veorq_u32(vshlcq_n_u32<26>(a), b), &w[12], &w[13]);
+  probe(veorq_u32(vshlcq_n_u32<30>(a), b), &w[14], &w[15]);
+  for (int j = 0; j < 4; ++j) {
+    transpose(&w[4 * j], &w[4 * j + 1], &w[4 * j + 2], &w[4 * j + 3]);
+    for (int k = 0; k < 4; ++k) {
+      mask[4 * k + j] = w[4 * j + k];
+    }
+  }
+}
+
+} // namespace neon_bloom_detail
+
+class neon_bloom_filter {
+public:
+  static const size_t kBlockBytes = 64;
+  static const int kProbes = 8;
+
+  // A filter of `bytes` bytes, rounded up to whole blocks.
+  explicit neon_bloom_filter(size_t bytes)
+    : blocks_((bytes + kBlockBytes - 1) / kBlockBytes ? (bytes + kBlockBytes - 1) / kBlockBytes : 1),
+      storage_(blocks_ * 16 + 15, 0)
+  {
+  }
+
+  // The blocks start at a different offset in the storage of a copy.
+  neon_bloom_filter(const neon_bloom_filter& other) : blocks_(other.blocks_), storage_(other.storage_.size(), 0)
+  {
+    std::copy(other.data(), other.data() + 16 * blocks_, data());
+  }
+
+  neon_bloom_filter(neon_bloom_filter&&) = default;
+
+  neon_bloom_filter& operator=(const neon_bloom_filter& other)
+  {
+    if (this != &other) {
+      *this = neon_bloom_filter(other);
+    }
+    return *this;
+  }
+
+  neon_bloom_filter& operator=(neon_bloom_filter&&) = default;
+
+  size_t bytes() const
+  {
+    return blocks_ * kBlockBytes;
+  }
+
+  void clear()
+  {
+    std::fill(storage_.begin(), storage_.end(), 0);
+  }
+
+  void insert(const uint64_t* keys, size_t n)
+  {
+    for (size_t i = 0; i < n; i += kBatch) {
+      const auto count = n - i < kBatch ? n - i : kBatch;
+      batch b;
+      hash(keys + i, count, &b);
+      for (size_t g = 0; g < count; g += 4) {
+        uint32x4_t mask[16];
+        neon_bloom_detail::masks(b.h1 + g, mask);
+        for (size_t k = 0; k < 4 && g + k < count; ++k) {
+          auto* block = data() + 16 * b.index[g + k];
+          for (int j = 0; j < 4; ++j) {
+            vst1q_u32(block + 4 * j, vorrq_u32(vld1q_u32(block + 4 * j), mask[4 * k + j]));
+          }
+        }
+      }
+    }
+  }
+
+  // found[i] = 1 when keys[i] may be in the set, 0 when it is not.
+  void contains(const uint64_t* keys, size_t n, uint8_t* found) const
+  {
+    for (size_t i = 0; i < n; i += kBatch) {
+      const auto count = n - i < kBatch ? n - i : kBatch;
+      batch b;
+      hash(keys + i, count, &b);
+      for (size_t g = 0; g < count; g += 4) {
+        uint32x4_t mask[16];
+        neon_bloom_detail::masks(b.h1 + g, mask);
+        for (size_t k = 0; k < 4 && g + k < count; ++k) {
+          const auto* block = data() + 16 * b.index[g + k];
+          auto missing = vdupq_n_u32(0);
+          for (int j = 0; j < 4; ++j) {
+            missing = vorrq_u32(missing, vbicq_u32(mask[4 * k + j], vld1q_u32(block + 4 * j)));
+          }
+          const auto m = vorr_u32(vget_low_u32(missing), vget_high_u32(missing));
+          found[i + g + k] = (vget_lane_u32(m, 0) | vget_lane_u32(m, 1)) == 0;
+        }
+      }
+    }
+  }
+
+  void insert(uint64_t key)
+  {
+    insert(&key, 1);
+  }
+
+  bool contains(uint64_t key) const
+  {
+    uint8_t found;
+    contains(&key, 1, &found);
+    return found != 0;
+  }
+
+private:
+  // Keys are hashed and their blocks prefetched a batch at a time, so the
+  // block loads of a batch overlap.
+  static const size_t kBatch = 32;
+
+  struct batch {
+    uint32_t h1[kBatch];
+    uint32_t index[kBatch];
+  };
+
+  void hash(const uint64_t* keys, size_t count, batch* b) const
+  {
+    // Whole groups of four, padded with key 0.
+    for (size_t k = 0; k < ((count + 3) & ~static_cast<size_t>(3)); ++k) {
+      const auto h = neon_bloom_detail::fmix64(k < count ? keys[k] : 0);
+      b->h1[k] = static_cast<uint32_t>(h);
+      b->index[k] = static_cast<uint32_t>(((h >> 32) * blocks_) >> 32);
+      if (k < count) {
+        __builtin_prefetch(data() + 16 * b->index[k]);
+      }
+    }
+  }
+
+  // The first block, at the first 64-byte boundary of the storage.
+  const uint32_t* data() const
+  {
+    const auto addr = reinterpret_cast<uintptr_t>(storage_.data());
+    return storage_.data() + ((kBlockBytes - addr % kBlockBytes) % kBlockBytes) / sizeof(uint32_t);
+  }
+
+  uint32_t* data()
+  {
+    return const_cast<uint32_t*>(static_cast<const neon_bloom_filter*>(this)->data());
+  }
+
+  size_t blocks_;
+  std::vector<uint32_t> storage_;
+};
+
+#endif /* NEON_BLOOM_H */
@@ -0,0 +1,219 @@
+#ifndef NEON_BUZHASH_H
+#define NEON_BUZHASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <arm_neon.h>
+
+#include <vector>
+
+#include "neon_circular_shift.h"
+#include "neon_xoshiro.h"
+
+// Content-defined chunking with a Buzhash rolling hash over a window of
+// `window` bytes:
+//   h(p) = rotl(h(p - 1), 1) ^ rotl(T[b(p - window)], window) ^ T[b(p)]
+// Byte p is a candidate boundary when the low bits of h(p) are zero. A chunk
+// ends at the first candidate at least `min_size` bytes after its start, or
+// after `max_size` bytes. The stream is preceded by `window` virtual zero
+// bytes, so h is defined from the first byte on.
+//
+// The hash depends only on the window, not on the chunk start, so each feed
+// is split into four segments that are hashed in the four lanes of a Q
+// register; boundaries are then chosen from the merged candidates.
+
+namespace neon_buzhash_detail {
+
+static inline uint32_t rotl(uint32_t v, int n)
+{
+  n &= 31;
+  return n ? (v << n) | (v >> (32 - n)) : v;
+}
+
+static inline bool any_lane(uint32x4_t v)
+{
+  const auto m = vpmax_u32(vget_low_u32(v), vget_high_u32(v));
+  return vget_lane_u32(vpmax_u32(m, m), 0) != 0;
+}
+
+} // namespace neon_buzhash_detail
+
+class neon_buzhash_chunker {
+public:
+  neon_buzhash_chunker(size_t min_size, size_t avg_size, size_t max_size,
+                       size_t window = 48, uint64_t seed = 0)
+    : min_(min_size), max_(max_size), window_(window)
+  {
+    neon_xoshiro128pp rng(seed);
+    rng.fill(table_, 256);
+    for (int i = 0; i < 256; ++i) {
+      table_out_[i] = neon_buzhash_detail::rotl(table_[i], static_cast<int>(window % 32));
+    }
+    // With candidates every 2^bits bytes on average, chunks average about
+    // min_size + 2^bits bytes.
+    const auto span = avg_size > min_size ? avg_size - min_size : 1;
+    int bits = 0;
+    while ((static_cast<size_t>(2) << bits) <= span) {
+      ++bits;
+    }
+    mask_ = (1U << bits) - 1;
+    reset();
+  }
+
+  void reset()
+  {
+    history_.assign(window_, 0);
+    hash_ = hash_window(history_.data());
+    pos_ = 0;
+    last_cut_ = 0;
+  }
+
+  // Appends the end offsets (absolute, in bytes) of the chunks completed by `data`.
+  void update(const uint8_t* data, size_t len, std::vector<uint64_t>* cuts)
+  {
+    candidates_.clear();
+    find_candidates(data, len);
+    pos_ += len;
+    select(cuts);
+
+    if (len >= window_) {
+      history_.assign(data + len - window_, data + len);
+    } else {
+      history_.erase(history_.begin(), history_.begin() + len);
+      history_.insert(history_.end(), data, data + len);
+    }
+  }
+
+  // Ends the last chunk at the end of the stream.
+  void finish(std::vector<uint64_t>* cuts)
+  {
+    if (pos_ > last_cut_) {
+      cuts->push_back(pos_);
+      last_cut_ = pos_;
+    }
+  }
+
+  uint32_t mask() const
+  {
+    return mask_;
+  }
+
+private:
+  static const size_t kBlock = 16;
+
+  uint32_t hash_window(const uint8_t* w) const
+  {
+    uint32_t h = 0;
+    for (size_t j = 0; j < window_; ++j) {
+      h ^= neon_buzhash_detail::rotl(table_[w[window_ - 1 - j]], static_cast<int>(j % 32));
+    }
+    return h;
+  }
+
+  // Bytes [begin, end) of `data` with begin >= window.
+  void scalar(const uint8_t* data, size_t begin, size_t end)
+  {
+    auto h = hash_;
+    for (size_t i = begin; i < end; ++i) {
+      h = neon_buzhash_detail::rotl(h, 1) ^ table_out_[data[i - window_]] ^ table_[data[i]];
+      if ((h & mask_) == 0) {
+        candidates_.push_back(pos_ + i);
+      }
+    }
+    hash_ = h;
+  }
+
+  void find_candidates(const uint8_t* data, size_t len)
+  {
+    // The first `window` bytes roll the outgoing bytes out of the history.
+    const auto prefix = len < window_ ? len : window_;
+    auto h = hash_;
+    for (size_t i = 0; i < prefix; ++i) {
+      h = neon_buzhash_detail::rotl(h, 1) ^ table_out_[history_[i]] ^ table_[data[i]];
+      if ((h & mask_) == 0) {
+        candidates_.push_back(pos_ + i);
+      }
+    }
+    hash_ = h;
+
+    const auto seg = (len - prefix) / 4;
+    size_t done = prefix;
+    if (seg >= kBlock) {
+      size_t start[4];
+      uint32_t init[4];
+      for (int k = 0; k < 4; ++k) {
+        start[k] = prefix + k * seg;
+        init[k] = k == 0 ? hash_ : hash_window(data + start[k] - window_);
+      }
+      std::vector<uint64_t> lane_candidates[4];
+      auto hv = vld1q_u32(init);
+      const auto mask = vdupq_n_u32(mask_);
+      uint32_t hashes[kBlock][4];
+      for (size_t i = 0; i < seg; i += kBlock) {
+        const auto n = seg - i < kBlock ? seg - i : kBlock;
+        auto any = vdupq_n_u32(0);
+        for (size_t j = 0; j < n; ++j) {
+          uint32_t t[4];
+          for (int k = 0; k < 4; ++k) {
+            const auto p = start[k] + i + j;
+            t[k] = table_out_[data[p - window_]] ^ table_[data[p]];
+          }
+          hv = veorq_u32(vshlcq_n_u32<1>(hv), vld1q_u32(t));
+          any = vorrq_u32(any, vceqq_u32(vandq_u32(hv, mask), vdupq_n_u32(0)));
+          vst1q_u32(hashes[j], hv);
+        }
+        if (neon_buzhash_detail::any_lane(any)) {
+          for (int k = 0; k < 4; ++k) {
+            for (size_t j = 0; j < n; ++j) {
+              if ((hashes[j][k] & mask_) == 0) {
+                lane_candidates[k].push_back(pos_ + start[k] + i + j);
+              }
+            }
+          }
+        }
+      }
+      for (int k = 0; k < 4; ++k) {
+        candidates_.insert(candidates_.end(), lane_candidates[k].begin(), lane_candidates[k].end());
+      }
+      hash_ = vgetq_lane_u32(hv, 3);
+      done = prefix + 4 * seg;
+    }
+    scalar(data, done, len);
+  }
+
+  void select(std::vector<uint64_t>* cuts)
+  {
+    size_t ci = 0;
+    for (;;) {
+      const auto limit = last_cut_ + max_;
+      while (ci < candidates_.size() && candidates_[ci] + 1 < last_cut_ + min_) {
+        ++ci;
+      }
+      if (ci < candidates_.size() && candidates_[ci] + 1 <= limit) {
+        last_cut_ = candidates_[ci] + 1;
+        ++ci;
+      } else if (limit <= pos_) {
+        last_cut_ = limit;
+      } else {
+        break;
+      }
+      cuts->push_back(last_cut_);
+    }
+  }
+
+  size_t min_;
+  size_t max_;
+  size_t window_;
+  uint32_t mask_;
+  uint32_t table_[256];
+  uint32_t table_out_[256];
+  std::vector<uint8_t> history_;
+  uint32_t hash_;
+  uint64_t pos_;
+  uint64_t last_cut_;
+  std::vector<uint64_t> candidates_;
+};
+
+#endif /* NEON_BUZHASH_H */
@@ -3,6 +3,48 @@
 
 #include <arm_neon.h>
 
+// Rotation by a whole number of bytes is a byte permutation within each lane:
+// byte j of the result is byte (j - bytes) of the source lane (little-endian).
+constexpr uint8_t vshlc_byte_index(int j, int bytes, int lane_bytes)
+{
+  return static_cast<uint8_t>((j & ~(lane_bytes - 1)) | ((j - bytes) & (lane_bytes - 1)));
+}
+
+#if defined(__aarch64__)
+// TBL with the index vector in a register. ARMv7 keeps VSHR + VSLI for the D
+// registers as well until the load of the table and VTBL are measured
+// against it on the in-order cores.
+template<int bytes, int lane_bytes>
+uint8x8_t vshlc_byte_rotate(uint8x8_t v)
+{
+  static const uint8_t kIdx[8] = {
+    vshlc_byte_index(0, bytes, lane_bytes), vshlc_byte_index(1, bytes, lane_bytes),
+    vshlc_byte_index(2, bytes, lane_bytes), vshlc_byte_index(3, bytes, lane_bytes),
+    vshlc_byte_index(4, bytes, lane_bytes), vshlc_byte_index(5, bytes, lane_bytes),
+    vshlc_byte_index(6, bytes, lane_bytes), vshlc_byte_index(7, bytes, lane_bytes),
+  };
+  return vtbl1_u8(v, vld1_u8(kIdx));
+}
+
+// A single TBL covers a Q register on AArch64; ARMv7 would need two VTBLs,
+// which is no better than VSHR + VSLI.
+template<int bytes, int lane_bytes>
+uint8x16_t vshlcq_byte_rotate(uint8x16_t v)
+{
+  static const uint8_t kIdx[16] = {
+    vshlc_byte_index(0, bytes, lane_bytes), vshlc_byte_index(1, bytes, lane_bytes),
+    vshlc_byte_index(2, bytes, lane_bytes), vshlc_byte_index(3, bytes, lane_bytes),
+    vshlc_byte_index(4, bytes, lane_bytes), vshlc_byte_index(5, bytes, lane_bytes),
+    vshlc_byte_index(6, bytes, lane_bytes), vshlc_byte_index(7, bytes, lane_bytes),
+    vshlc_byte_index(8, bytes, lane_bytes), vshlc_byte_index(9, bytes, lane_bytes),
+    vshlc_byte_index(10, bytes, lane_bytes), vshlc_byte_index(11, bytes, lane_bytes),
+    vshlc_byte_index(12, bytes, lane_bytes), vshlc_byte_index(13, bytes, lane_bytes),
+    vshlc_byte_index(14, bytes, lane_bytes), vshlc_byte_index(15, bytes, lane_bytes),
+  };
+  return vqtbl1q_u8(v, vld1q_u8(kIdx));
+}
+#endif
+
 template<int n>
 uint8x8_t vshlc_n_u8(uint8x8_t v)
 {
@@ -32,6 +74,13 @@ uint32x2_t vshlc_n_u32(uint32x2_t v)
     const auto ret = vrev32_u16(tmp);
     return vreinterpret_u32_u16(ret);
   }
+#if defined(__aarch64__)
+  if (n % 8 == 0 && n != 0) {
+    const auto tmp = vreinterpret_u8_u32(v);
+    const auto ret = vshlc_byte_rotate<n / 8, 4>(tmp);
+    return vreinterpret_u32_u8(ret);
+  }
+#endif
   const auto tmp = vshr_n_u32(v, 32 - n);
   const auto ret = vsli_n_u32(tmp, v, n);
   return ret;
@@ -45,6 +94,13 @@ uint64x1_t vshlc_n_u64(uint64x1_t v)
     const auto ret = vrev64_u32(tmp);
     return vreinterpret_u64_u32(ret);
   }
+#if defined(__aarch64__)
+  if (n % 8 == 0 && n != 0) {
+    const auto tmp = vreinterpret_u8_u64(v);
+    const auto ret = vshlc_byte_rotate<n / 8, 8>(tmp);
+    return vreinterpret_u64_u8(ret);
+  }
+#endif
   const auto tmp = vshr_n_u64(v, 64 - n);
   const auto ret = vsli_n_u64(tmp, v, n);
   return ret;
@@ -79,6 +135,13 @@ uint32x4_t vshlcq_n_u32(uint32x4_t v)
     const auto ret = vrev32q_u16(tmp);
     return vreinterpretq_u32_u16(ret);
   }
+#if defined(__aarch64__)
+  if (n % 8 == 0 && n != 0) {
+    const auto tmp = vreinterpretq_u8_u32(v);
+    const auto ret = vshlcq_byte_rotate<n / 8, 4>(tmp);
+    return vreinterpretq_u32_u8(ret);
+  }
+#endif
   const auto tmp = vshrq_n_u32(v, 32 - n);
   const auto ret = vsliq_n_u32(tmp, v, n);
   return ret;
@@ -92,6 +155,13 @@ uint64x2_t vshlcq_n_u64(uint64x2_t v)
     const auto ret = vrev64q_u32(tmp);
     return vreinterpretq_u64_u32(ret);
   }
+#if defined(__aarch64__)
+  if (n % 8 == 0 && n != 0) {
+    const auto tmp = vreinterpretq_u8_u64(v);
+    const auto ret = vshlcq_byte_rotate<n / 8, 8>(tmp);
+    return vreinterpretq_u64_u8(ret);
+  }
+#endif
   const auto tmp = vshrq_n_u64(v, 64 - n);
   const auto ret = vsliq_n_u64(tmp, v, n);
   return ret;
@@ -0,0 +1,146 @@
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include <algorithm>
+
+#include "neon_circular_shift_arena.h"
+
+namespace {
+
+const size_t kPage = 4096;
+const size_t kHugePage = 2 << 20;
+const size_t kMinBlock = 64 << 10;
+
+size_t round_up(size_t v, size_t to)
+{
+  return (v + to - 1) / to * to;
+}
+
+#if defined(__linux__)
+// size bytes at a multiple of align, cut from a larger anonymous mapping.
+void* map_aligned(size_t size, size_t align)
+{
+  const auto span = size + align;
+  void* p = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    return nullptr;
+  }
+  const auto start = reinterpret_cast<uintptr_t>(p);
+  const auto aligned = round_up(start, align);
+  if (aligned > start) {
+    munmap(p, aligned - start);
+  }
+  if (start + span > aligned + size) {
+    munmap(reinterpret_cast<void*>(aligned + size), start + span - aligned - size);
+  }
+  return reinterpret_cast<void*>(aligned);
+}
+#endif
+
+} // namespace
+
+shlc_arena::shlc_arena(bool huge_pages) : huge_pages_(huge_pages)
+{
+}
+
+shlc_arena::~shlc_arena()
+{
+  unmap_all();
+}
+
+void* shlc_arena::alloc(size_t bytes)
+{
+  bytes = round_up(std::max<size_t>(bytes, 1), kAlign);
+  if (blocks_.empty() || blocks_.back().size - used_ < bytes) {
+    const auto last = blocks_.empty() ? 0 : blocks_.back().size;
+    if (!map(std::max(bytes, 2 * last))) {
+      return nullptr;
+    }
+  }
+  auto* p = blocks_.back().base + used_;
+  used_ += bytes;
+  return p;
+}
+
+void shlc_arena::reset()
+{
+  if (blocks_.size() > 1) {
+    const auto total = capacity();
+    unmap_all();
+    map(total);
+  }
+  used_ = 0;
+}
+
+size_t shlc_arena::capacity() const
+{
+  size_t total = 0;
+  for (const auto& b : blocks_) {
+    total += b.size;
+  }
+  return total;
+}
+
+bool shlc_arena::hugetlb() const
+{
+  for (const auto& b : blocks_) {
+    if (!b.hugetlb) {
+      return false;
+    }
+  }
+  return !blocks_.empty();
+}
+
+bool shlc_arena::map(size_t bytes)
+{
+  block b;
+  b.size = round_up(std::max(bytes, kMinBlock), huge_pages_ ? kHugePage : kPage);
+  b.hugetlb = false;
+#if defined(__linux__)
+  void* p = nullptr;
+#if defined(MAP_HUGETLB)
+  if (huge_pages_) {
+    p = mmap(nullptr, b.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    p = p == MAP_FAILED ? nullptr : p;
+    b.hugetlb = p != nullptr;
+  }
+#endif
+  if (!p) {
+    p = map_aligned(b.size, huge_pages_ ? kHugePage : kPage);
+#if defined(MADV_HUGEPAGE)
+    if (p && huge_pages_) {
+      madvise(p, b.size, MADV_HUGEPAGE);
+    }
+#endif
+  }
+#else
+  void* p = nullptr;
+  if (posix_memalign(&p, kPage, b.size) != 0) {
+    p = nullptr;
+  }
+#endif
+  if (!p) {
+    return false;
+  }
+  b.base = static_cast<char*>(p);
+  blocks_.push_back(b);
+  used_ = 0;
+  return true;
+}
+
+void shlc_arena::unmap_all()
+{
+  for (const auto& b : blocks_) {
+#if defined(__linux__)
+    munmap(b.base, b.size);
+#else
+    free(b.base);
+#endif
+  }
+  blocks_.clear();
+  used_ = 0;
+}
@@ -0,0 +1,72 @@
+#ifndef NEON_CIRCULAR_SHIFT_ARENA_H
+#define NEON_CIRCULAR_SHIFT_ARENA_H
+
+#include <cstddef>
+
+#include <vector>
+
+// Buffers for the kernels, 64-byte aligned so that no vector load or store
+// splits a cache line, and optionally on huge pages so that large buffers
+// do not miss the TLB every 4 KB. An arena hands out buffers from a few large
+// mappings and takes them all back at once, so a loop that allocates the
+// same buffers every round maps memory only in the first one:
+//
+//   shlc_arena arena(true);
+//   for (const auto& batch : batches) {
+//     auto* dst = arena.alloc<uint32_t>(batch.len);
+//     shlc_bulk_u32(batch.data, dst, batch.len, n);
+//     ...
+//     arena.reset();
+//   }
+//
+// With huge pages the arena asks for explicit ones (MAP_HUGETLB), which
+// need pages reserved in /proc/sys/vm/nr_hugepages, and otherwise maps
+// 2 MB-aligned memory and advises transparent huge pages on it (MADV_HUGEPAGE).
+// Not thread-safe; one arena per thread.
+
+class shlc_arena {
+public:
+  static const size_t kAlign = 64;
+
+  explicit shlc_arena(bool huge_pages = false);
+  ~shlc_arena();
+
+  shlc_arena(const shlc_arena&) = delete;
+  shlc_arena& operator=(const shlc_arena&) = delete;
+
+  // bytes rounded up to kAlign, valid until reset(); null when no memory
+  // can be mapped.
+  void* alloc(size_t bytes);
+
+  template<typename T>
+  T* alloc(size_t n)
+  {
+    return static_cast<T*>(alloc(n * sizeof(T)));
+  }
+
+  // Takes back every buffer. Memory in several mappings is merged into one,
+  // which the next round of the same allocations fits in.
+  void reset();
+
+  // Bytes mapped.
+  size_t capacity() const;
+
+  // Whether all of the mapped memory is on explicit huge pages.
+  bool hugetlb() const;
+
+private:
+  struct block {
+    char* base;
+    size_t size;
+    bool hugetlb;
+  };
+
+  bool map(size_t bytes);
+  void unmap_all();
+
+  bool huge_pages_;
+  std::vector<block> blocks_;
+  size_t used_ = 0;  // of the last block
+};
+
+#endif /* NEON_CIRCULAR_SHIFT_ARENA_H */
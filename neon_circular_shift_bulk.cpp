@@ -0,0 +1,630 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__)
+#include <sys/auxv.h>
+#endif
+
+#include <arm_neon.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "neon_circular_shift.h"
+#include "neon_circular_shift_bulk.h"
+#include "neon_circular_shift_bulk_impl.h"
+#include "neon_circular_shift_tune.h"
+
+namespace {
+
+#if defined(__linux__) && (defined(__aarch64__) || defined(__arm__))
+#define NEON_CIRCULAR_SHIFT_BULK_HWCAP 1
+
+// From the kernel's asm/hwcap.h, which older C libraries do not have.
+#if defined(__aarch64__)
+const unsigned long kHwcapAsimd = 1ul << 1;
+const unsigned long kHwcapSha3 = 1ul << 17;
+const unsigned long kHwcap2Sve2 = 1ul << 1;
+#else
+const unsigned long kHwcapNeon = 1ul << 12;
+#endif
+
+bool hwcap(unsigned long type, unsigned long bit)
+{
+  return (getauxval(type) & bit) != 0;
+}
+#endif
+
+bool cpu_supports(shlc_backend b)
+{
+  switch (b) {
+  case shlc_backend::c:
+    return true;
+  case shlc_backend::neon:
+#if defined(NEON_CIRCULAR_SHIFT_BULK_HWCAP) && defined(__aarch64__)
+    return hwcap(AT_HWCAP, kHwcapAsimd);
+#elif defined(NEON_CIRCULAR_SHIFT_BULK_HWCAP)
+    return hwcap(AT_HWCAP, kHwcapNeon);
+#else
+    return true;  // the build requires it
+#endif
+#if defined(NEON_CIRCULAR_SHIFT_BULK_HWCAP) && defined(NEON_CIRCULAR_SHIFT_BULK_SHA3)
+  case shlc_backend::sha3:
+    return hwcap(AT_HWCAP, kHwcapSha3);
+#endif
+#if defined(NEON_CIRCULAR_SHIFT_BULK_HWCAP) && defined(NEON_CIRCULAR_SHIFT_BULK_SVE2)
+  case shlc_backend::sve2:
+    return hwcap(AT_HWCAP2, kHwcap2Sve2);
+#endif
+  default:
+    return false;
+  }
+}
+
+template<typename T, int n>
+struct c_kernel {
+  static void run(const T* src, T* dst, size_t len, size_t)
+  {
+    for (size_t i = 0; i < len; ++i) {
+      dst[i] = shlc_bulk_rotl(src[i], n);
+    }
+  }
+};
+
+// Loads, stores and vshlc(q)_n for D (q = false) and Q registers.
+template<typename T, bool q>
+struct vec;
+
+#define SHLC_BULK_VEC(T, q, V, load_fn, store_fn, rotl_fn) \
+  template<>                                               \
+  struct vec<T, q> {                                       \
+    typedef V type;                                        \
+    static V load(const T* p)                              \
+    {                                                      \
+      return load_fn(p);                                   \
+    }                                                      \
+    static void store(T* p, V v)                           \
+    {                                                      \
+      store_fn(p, v);                                      \
+    }                                                      \
+    template<int n>                                        \
+    static V rotl(V v)                                     \
+    {                                                      \
+      return rotl_fn<n>(v);                                \
+    }                                                      \
+  };
+
+SHLC_BULK_VEC(uint8_t, false, uint8x8_t, vld1_u8, vst1_u8, vshlc_n_u8)
+SHLC_BULK_VEC(uint16_t, false, uint16x4_t, vld1_u16, vst1_u16, vshlc_n_u16)
+SHLC_BULK_VEC(uint32_t, false, uint32x2_t, vld1_u32, vst1_u32, vshlc_n_u32)
+SHLC_BULK_VEC(uint64_t, false, uint64x1_t, vld1_u64, vst1_u64, vshlc_n_u64)
+SHLC_BULK_VEC(uint8_t, true, uint8x16_t, vld1q_u8, vst1q_u8, vshlcq_n_u8)
+SHLC_BULK_VEC(uint16_t, true, uint16x8_t, vld1q_u16, vst1q_u16, vshlcq_n_u16)
+SHLC_BULK_VEC(uint32_t, true, uint32x4_t, vld1q_u32, vst1q_u32, vshlcq_n_u32)
+SHLC_BULK_VEC(uint64_t, true, uint64x2_t, vld1q_u64, vst1q_u64, vshlcq_n_u64)
+
+#undef SHLC_BULK_VEC
+
+// Q loads and stores of 16-byte aligned addresses. On ARMv7 they carry the
+// :128 hint, which spares the core the check for a line split; AArch64 has
+// no hints, and the compiler is only told the alignment.
+template<typename T>
+struct aligned_vec {
+  typedef typename vec<T, true>::type type;
+
+  static type load(const T* p)
+  {
+#if defined(__arm__)
+    type v;
+    __asm__("vld1.64 {%e0-%f0}, [%1:128]" : "=w"(v) : "r"(p), "m"(*reinterpret_cast<const uint8_t(*)[16]>(p)));
+    return v;
+#else
+    return vec<T, true>::load(static_cast<const T*>(__builtin_assume_aligned(p, 16)));
+#endif
+  }
+
+  static void store(T* p, type v)
+  {
+#if defined(__arm__)
+    __asm__("vst1.64 {%e1-%f1}, [%2:128]" : "=m"(*reinterpret_cast<uint8_t(*)[16]>(p)) : "w"(v), "r"(p));
+#else
+    vec<T, true>::store(static_cast<T*>(__builtin_assume_aligned(p, 16)), v);
+#endif
+  }
+
+  template<int n>
+  static type rotl(type v)
+  {
+    return vec<T, true>::template rotl<n>(v);
+  }
+};
+
+// kUnroll vectors per iteration, all loaded before any is rotated or stored
+// so that their latencies overlap. kAligned kernels need src and dst 16-byte
+// aligned, and Q registers.
+template<bool q, int kUnroll, bool kAligned = false>
+struct neon_variant {
+  template<typename T, int n>
+  struct kernel {
+    static void run(const T* src, T* dst, size_t len, size_t prefetch)
+    {
+      typedef typename std::conditional<kAligned, aligned_vec<T>, vec<T, q>>::type V;
+      static const size_t kLanes = (q ? 16 : 8) / sizeof(T);
+      size_t i = 0;
+      for (; i + kLanes * kUnroll <= len; i += kLanes * kUnroll) {
+        shlc_bulk_prefetch(src + i, prefetch);
+        typename V::type v[kUnroll];
+        for (int u = 0; u < kUnroll; ++u) {
+          v[u] = V::load(src + i + u * kLanes);
+        }
+        for (int u = 0; u < kUnroll; ++u) {
+          V::store(dst + i + u * kLanes, V::template rotl<n>(v[u]));
+        }
+      }
+      for (; i + kLanes <= len; i += kLanes) {
+        V::store(dst + i, V::template rotl<n>(V::load(src + i)));
+      }
+      for (; i < len; ++i) {
+        dst[i] = shlc_bulk_rotl(src[i], n);
+      }
+    }
+  };
+};
+
+// For buffers past the last-level cache: whole 64-byte lines of dst, each
+// written by a pair of STNP on AArch64, with the source prefetched at the
+// streaming hint (PRFM PLDL1STRM; PLD on ARMv7, which has no non-temporal
+// store). DC ZVA is not used: it saves the read of dst as well, but
+// allocates the zeroed line in the cache.
+template<typename T, int n>
+struct stream_kernel {
+  typedef vec<T, true> V;
+  static const size_t kLanes = 16 / sizeof(T);
+
+  static void store_pair(T* p, typename V::type a, typename V::type b)
+  {
+#if defined(__aarch64__)
+    __asm__ volatile("stnp %q1, %q2, [%0]" : : "r"(p), "w"(a), "w"(b) : "memory");
+#else
+    V::store(p, a);
+    V::store(p + kLanes, b);
+#endif
+  }
+
+  static void run(const T* src, T* dst, size_t len, size_t prefetch)
+  {
+    typedef typename neon_variant<true, 1>::template kernel<T, n> plain;
+    static const size_t kLine = 64 / sizeof(T);
+    const auto misalign = reinterpret_cast<uintptr_t>(dst) % 64;
+    auto i = std::min(len, (64 - misalign) % 64 / sizeof(T));
+    plain::run(src, dst, i, 0);
+    for (; i + kLine <= len; i += kLine) {
+      if (prefetch) {
+        __builtin_prefetch(reinterpret_cast<const char*>(src + i) + prefetch, 0, 0);
+      }
+      const auto v0 = V::load(src + i);
+      const auto v1 = V::load(src + i + kLanes);
+      const auto v2 = V::load(src + i + 2 * kLanes);
+      const auto v3 = V::load(src + i + 3 * kLanes);
+      store_pair(dst + i, V::template rotl<n>(v0), V::template rotl<n>(v1));
+      store_pair(dst + i + 2 * kLanes, V::template rotl<n>(v2), V::template rotl<n>(v3));
+    }
+    plain::run(src + i, dst + i, len - i, 0);
+  }
+};
+
+// Data and unified cache sizes of cpu0 from sysfs, the largest; 8 MB when
+// there are none.
+size_t last_level_cache()
+{
+  size_t largest = 0;
+  for (int i = 0; i < 8; ++i) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", i);
+    auto f = fopen(path, "r");
+    if (!f) {
+      break;
+    }
+    char type[32] = {};
+    const auto ok = fscanf(f, "%31s", type) == 1;
+    fclose(f);
+    if (!ok || strcmp(type, "Instruction") == 0) {
+      continue;
+    }
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", i);
+    f = fopen(path, "r");
+    if (!f) {
+      continue;
+    }
+    size_t size = 0;
+    char unit = 0;
+    const auto fields = fscanf(f, "%zu%c", &size, &unit);
+    fclose(f);
+    if (fields >= 1) {
+      size <<= unit == 'K' ? 10 : unit == 'M' ? 20 : unit == 'G' ? 30 : 0;
+      largest = std::max(largest, size);
+    }
+  }
+  return largest ? largest : 8 << 20;
+}
+
+template<typename T, bool q, bool aligned = false>
+const shlc_bulk_kernel<T>* neon_kernels(int unroll)
+{
+  switch (unroll) {
+  case 2:
+    return shlc_bulk_table<T, neon_variant<q, 2, aligned>::template kernel>();
+  case 4:
+    return shlc_bulk_table<T, neon_variant<q, 4, aligned>::template kernel>();
+  case 8:
+    return shlc_bulk_table<T, neon_variant<q, 8, aligned>::template kernel>();
+  default:
+    return shlc_bulk_table<T, neon_variant<q, 1, aligned>::template kernel>();
+  }
+}
+
+template<typename T>
+const shlc_bulk_kernel<T>* sha3_kernels()
+{
+  return nullptr;
+}
+
+#if defined(NEON_CIRCULAR_SHIFT_BULK_SHA3)
+template<>
+const shlc_bulk_kernel<uint64_t>* sha3_kernels<uint64_t>()
+{
+  return shlc_bulk_sha3_u64();
+}
+#endif
+
+// The kernels of b for T, or null.
+template<typename T>
+const shlc_bulk_kernel<T>* kernels(shlc_backend b, bool q = true, int unroll = 1)
+{
+  switch (b) {
+  case shlc_backend::c:
+    return shlc_bulk_table<T, c_kernel>();
+  case shlc_backend::neon:
+    return q ? neon_kernels<T, true>(unroll) : neon_kernels<T, false>(unroll);
+  case shlc_backend::sha3:
+    return sha3_kernels<T>();
+#if defined(NEON_CIRCULAR_SHIFT_BULK_SVE2)
+  case shlc_backend::sve2:
+    return shlc_bulk_sve2<T>();
+#endif
+  default:
+    return nullptr;
+  }
+}
+
+shlc_backend parse_backend(const char* s)
+{
+  for (const auto b : { shlc_backend::c, shlc_backend::neon, shlc_backend::sha3, shlc_backend::sve2 }) {
+    if (s && strcmp(s, shlc_backend_name(b)) == 0) {
+      return b;
+    }
+  }
+  return shlc_backend::automatic;
+}
+
+std::atomic<shlc_backend>& cap()
+{
+  static std::atomic<shlc_backend> c(parse_backend(getenv("NEON_CIRCULAR_SHIFT_BACKEND")));
+  return c;
+}
+
+// The configuration, chosen backend and kernels for T. The kernels are
+// resolved on first use and again after the backend or the configuration
+// changes.
+template<typename T>
+struct dispatch {
+  static std::atomic<const shlc_bulk_kernel<T>*> kernels;
+  static std::atomic<const shlc_bulk_kernel<T>*> stream_kernels;  // null for c
+  static std::atomic<const shlc_bulk_kernel<T>*> aligned_kernels;  // neon, Q only
+  static std::atomic<shlc_backend> backend;
+  static std::atomic<bool> q;
+  static std::atomic<int> unroll;
+  static std::atomic<size_t> prefetch;
+  static std::atomic<size_t> chunk;
+  static std::atomic<size_t> stream;
+  static std::atomic<size_t> stream_prefetch;
+  static std::atomic<bool> aligned;
+};
+
+template<typename T>
+std::atomic<const shlc_bulk_kernel<T>*> dispatch<T>::kernels(nullptr);
+
+template<typename T>
+std::atomic<const shlc_bulk_kernel<T>*> dispatch<T>::stream_kernels(nullptr);
+
+template<typename T>
+std::atomic<const shlc_bulk_kernel<T>*> dispatch<T>::aligned_kernels(nullptr);
+
+template<typename T>
+std::atomic<shlc_backend> dispatch<T>::backend(shlc_backend::automatic);
+
+template<typename T>
+std::atomic<bool> dispatch<T>::q(true);
+
+template<typename T>
+std::atomic<int> dispatch<T>::unroll(1);
+
+template<typename T>
+std::atomic<size_t> dispatch<T>::prefetch(0);
+
+template<typename T>
+std::atomic<size_t> dispatch<T>::chunk(0);
+
+template<typename T>
+std::atomic<size_t> dispatch<T>::stream(0);
+
+template<typename T>
+std::atomic<size_t> dispatch<T>::stream_prefetch(1024);
+
+template<typename T>
+std::atomic<bool> dispatch<T>::aligned(true);
+
+// A tuning file named in the environment applies before the first call of
+// any bulk function takes effect, so that the configuration it sets is the
+// one every caller sees. Loading the file sets the configuration itself,
+// which comes back here on the loading thread.
+void load_tuning_once()
+{
+  static thread_local bool loading = false;
+  if (loading) {
+    return;
+  }
+  static std::once_flag once;
+  std::call_once(once, []() {
+    const char* path = getenv("NEON_CIRCULAR_SHIFT_TUNING");
+    if (path) {
+      loading = true;
+      shlc_bulk_load_tuning(path);
+      loading = false;
+    }
+  });
+}
+
+template<typename T>
+const shlc_bulk_kernel<T>* resolve()
+{
+  load_tuning_once();
+  const auto limit = cap().load();
+  for (const auto b : { shlc_backend::sve2, shlc_backend::sha3, shlc_backend::neon, shlc_backend::c }) {
+    if (limit != shlc_backend::automatic && b > limit) {
+      continue;
+    }
+    const auto k = kernels<T>(b, dispatch<T>::q.load(), dispatch<T>::unroll.load());
+    if (k && cpu_supports(b)) {
+      const auto s = b >= shlc_backend::neon ? shlc_bulk_table<T, stream_kernel>() : nullptr;
+      dispatch<T>::stream_kernels.store(s);
+      const auto aligned = b == shlc_backend::neon && dispatch<T>::q.load() && dispatch<T>::aligned.load();
+      dispatch<T>::aligned_kernels.store(aligned ? neon_kernels<T, true, true>(dispatch<T>::unroll.load()) : nullptr);
+      dispatch<T>::backend.store(b);
+      dispatch<T>::kernels.store(k, std::memory_order_release);
+      return k;
+    }
+  }
+  return nullptr;  // not reached: c always has kernels
+}
+
+template<typename T>
+shlc_backend backend()
+{
+  if (!dispatch<T>::kernels.load(std::memory_order_acquire)) {
+    resolve<T>();
+  }
+  return dispatch<T>::backend.load();
+}
+
+template<typename T>
+void set_config(const shlc_bulk_config& c)
+{
+  dispatch<T>::q.store(c.q);
+  dispatch<T>::unroll.store(c.unroll);
+  dispatch<T>::prefetch.store(c.prefetch);
+  dispatch<T>::chunk.store(c.chunk);
+  dispatch<T>::stream.store(c.stream);
+  dispatch<T>::stream_prefetch.store(c.stream_prefetch);
+  dispatch<T>::aligned.store(c.aligned);
+  dispatch<T>::kernels.store(nullptr);
+}
+
+template<typename T>
+shlc_bulk_config get_config()
+{
+  shlc_bulk_config c;
+  c.q = dispatch<T>::q.load();
+  c.unroll = dispatch<T>::unroll.load();
+  c.prefetch = dispatch<T>::prefetch.load();
+  c.chunk = dispatch<T>::chunk.load();
+  c.stream = dispatch<T>::stream.load();
+  c.stream_prefetch = dispatch<T>::stream_prefetch.load();
+  c.aligned = dispatch<T>::aligned.load();
+  return c;
+}
+
+template<typename T>
+size_t stream_threshold()
+{
+  static const size_t kLastLevel = last_level_cache();
+  const auto s = dispatch<T>::stream.load(std::memory_order_relaxed);
+  return s ? s : kLastLevel;
+}
+
+template<typename T>
+void shlc_bulk(const T* src, T* dst, size_t len, int n)
+{
+  static const int kBits = 8 * sizeof(T);
+  n &= kBits - 1;
+#if defined(NEON_CIRCULAR_SHIFT_STATS)
+  const shlc_bulk_stats_scope stats(kBits, n, len);
+#endif
+  if (n == 0) {
+    if (src != dst) {
+      memcpy(dst, src, len * sizeof(T));
+    }
+    return;
+  }
+  auto k = dispatch<T>::kernels.load(std::memory_order_acquire);
+  if (!k) {
+    k = resolve<T>();
+  }
+  auto kernel = k[n - 1];
+  auto prefetch = dispatch<T>::prefetch.load(std::memory_order_relaxed);
+  const auto a = dispatch<T>::aligned_kernels.load(std::memory_order_relaxed);
+  if (a && (reinterpret_cast<uintptr_t>(src) | reinterpret_cast<uintptr_t>(dst)) % 16 == 0) {
+    kernel = a[n - 1];
+  }
+  const auto s = dispatch<T>::stream_kernels.load(std::memory_order_relaxed);
+  if (s && (src == dst ? 1 : 2) * len * sizeof(T) >= stream_threshold<T>()) {
+    kernel = s[n - 1];
+    prefetch = dispatch<T>::stream_prefetch.load(std::memory_order_relaxed);
+  }
+  const auto chunk = dispatch<T>::chunk.load(std::memory_order_relaxed) / sizeof(T);
+  const auto cores = std::max(1u, std::thread::hardware_concurrency());
+  const auto threads = chunk ? std::min<size_t>(len / chunk, cores) : 1;
+  if (threads < 2) {
+    kernel(src, dst, len, prefetch);
+    return;
+  }
+  // Contiguous shares of whole cache lines; the calling thread takes the
+  // first one.
+  const size_t line = 64 / sizeof(T);
+  const auto per_thread = ((len + threads - 1) / threads + line - 1) / line * line;
+  std::vector<std::thread> pool;
+  for (size_t b = per_thread; b < len; b += per_thread) {
+    const auto e = std::min(len, b + per_thread);
+    pool.emplace_back([=]() {
+      kernel(src + b, dst + b, e - b, prefetch);
+    });
+  }
+  kernel(src, dst, std::min(len, per_thread), prefetch);
+  for (auto& th : pool) {
+    th.join();
+  }
+}
+
+} // namespace
+
+void shlc_bulk_u8(const uint8_t* src, uint8_t* dst, size_t len, int n)
+{
+  shlc_bulk(src, dst, len, n);
+}
+
+void shlc_bulk_u16(const uint16_t* src, uint16_t* dst, size_t len, int n)
+{
+  shlc_bulk(src, dst, len, n);
+}
+
+void shlc_bulk_u32(const uint32_t* src, uint32_t* dst, size_t len, int n)
+{
+  shlc_bulk(src, dst, len, n);
+}
+
+void shlc_bulk_u64(const uint64_t* src, uint64_t* dst, size_t len, int n)
+{
+  shlc_bulk(src, dst, len, n);
+}
+
+bool shlc_bulk_supported(shlc_backend b)
+{
+  return b == shlc_backend::automatic || (kernels<uint64_t>(b) && cpu_supports(b));
+}
+
+bool shlc_bulk_force_backend(shlc_backend b)
+{
+  load_tuning_once();
+  if (!shlc_bulk_supported(b)) {
+    return false;
+  }
+  cap().store(b);
+  dispatch<uint8_t>::kernels.store(nullptr);
+  dispatch<uint16_t>::kernels.store(nullptr);
+  dispatch<uint32_t>::kernels.store(nullptr);
+  dispatch<uint64_t>::kernels.store(nullptr);
+  return true;
+}
+
+shlc_backend shlc_bulk_forced_backend()
+{
+  load_tuning_once();
+  return cap().load();
+}
+
+shlc_backend shlc_bulk_backend(int width)
+{
+  switch (width) {
+  case 8:
+    return backend<uint8_t>();
+  case 16:
+    return backend<uint16_t>();
+  case 32:
+    return backend<uint32_t>();
+  case 64:
+    return backend<uint64_t>();
+  }
+  return shlc_backend::automatic;
+}
+
+bool shlc_bulk_set_config(int width, const shlc_bulk_config& c)
+{
+  load_tuning_once();
+  if (c.unroll != 1 && c.unroll != 2 && c.unroll != 4 && c.unroll != 8) {
+    return false;
+  }
+  switch (width) {
+  case 8:
+    set_config<uint8_t>(c);
+    return true;
+  case 16:
+    set_config<uint16_t>(c);
+    return true;
+  case 32:
+    set_config<uint32_t>(c);
+    return true;
+  case 64:
+    set_config<uint64_t>(c);
+    return true;
+  }
+  return false;
+}
+
+shlc_bulk_config shlc_bulk_get_config(int width)
+{
+  load_tuning_once();
+  switch (width) {
+  case 8:
+    return get_config<uint8_t>();
+  case 16:
+    return get_config<uint16_t>();
+  case 32:
+    return get_config<uint32_t>();
+  case 64:
+    return get_config<uint64_t>();
+  }
+  return shlc_bulk_config();
+}
+
+const char* shlc_backend_name(shlc_backend b)
+{
+  switch (b) {
+  case shlc_backend::automatic:
+    return "automatic";
+  case shlc_backend::c:
+    return "c";
+  case shlc_backend::neon:
+    return "neon";
+  case shlc_backend::sha3:
+    return "sha3";
+  case shlc_backend::sve2:
+    return "sve2";
+  }
+  return "unknown";
+}
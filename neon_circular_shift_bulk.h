@@ -0,0 +1,83 @@
+#ifndef NEON_CIRCULAR_SHIFT_BULK_H
+#define NEON_CIRCULAR_SHIFT_BULK_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Rotation of whole buffers by a shift count known only at run time, for one
+// binary that runs on several kinds of cores. On its first call each function
+// picks the best kernel the CPU supports, from getauxval(AT_HWCAP) and
+// getauxval(AT_HWCAP2), and keeps it:
+//
+// - c:    plain C++, left to the compiler;
+// - neon: the vshlcq_n_* kernels (ARMv7 NEON, AArch64 Advanced SIMD);
+// - sha3: XAR on 64-bit lanes (Armv8.2-A SHA3 extension, AArch64);
+// - sve2: XAR at the vector length of the CPU (AArch64).
+//
+// sha3 and sve2 are built with cmake -DMY_ARCH=aarch64; a function skips a
+// backend it has no kernel for (sha3 only has u64).
+//
+// For testing, NEON_CIRCULAR_SHIFT_BACKEND=c|neon|sha3|sve2 in the
+// environment or shlc_bulk_force_backend() caps the choice: each function
+// uses the best supported backend that is not better than the one given.
+//
+// Calls whose buffers do not fit in the last-level cache use streaming NEON
+// kernels (unless the backend is c): the source is prefetched with the streaming hint and, on AArch64,
+// the destination is written with STNP, so that the call leaves the caches
+// of other code alone.
+//
+// dst may be src; otherwise the buffers must not overlap. n is taken modulo
+// the lane width, so that a negative n rotates right.
+
+enum class shlc_backend {
+  automatic,
+  c,
+  neon,
+  sha3,
+  sve2,
+};
+
+void shlc_bulk_u8(const uint8_t* src, uint8_t* dst, size_t len, int n);
+void shlc_bulk_u16(const uint16_t* src, uint16_t* dst, size_t len, int n);
+void shlc_bulk_u32(const uint32_t* src, uint32_t* dst, size_t len, int n);
+void shlc_bulk_u64(const uint64_t* src, uint64_t* dst, size_t len, int n);
+
+// Whether the build has b and the CPU supports it.
+bool shlc_bulk_supported(shlc_backend b);
+
+// Caps the backends as described above; automatic removes the cap. Returns
+// false, and changes nothing, when b is not supported.
+bool shlc_bulk_force_backend(shlc_backend b);
+
+// The cap set by shlc_bulk_force_backend() or the environment; automatic
+// when there is none.
+shlc_backend shlc_bulk_forced_backend();
+
+// The backend shlc_bulk_u<width> uses.
+shlc_backend shlc_bulk_backend(int width);
+
+// How shlc_bulk_u<width> runs, normally set from a tuning file (see
+// neon_circular_shift_tune.h). The defaults are those of an untuned build.
+struct shlc_bulk_config {
+  bool q = true;        // Q registers, or D (neon backend)
+  int unroll = 1;       // vectors per iteration: 1, 2, 4 or 8 (neon backend)
+  size_t prefetch = 0;  // bytes ahead of the loads to prefetch; 0 for none
+  size_t chunk = 0;     // least bytes per thread; 0 to stay on the calling thread
+  // Least bytes of src and dst (once when in place) for the streaming
+  // kernels: 0 for the size of the last-level cache, SIZE_MAX for never.
+  size_t stream = 0;
+  size_t stream_prefetch = 1024;  // prefetch distance of the streaming kernels
+  // Kernels with aligned loads and stores when src and dst are 16-byte
+  // aligned, e.g. from a shlc_arena (neon backend, Q registers).
+  bool aligned = true;
+};
+
+// Meant for start-up: calls running at the same time may see a mix of the
+// old and the new configuration. False for an invalid width or unroll.
+bool shlc_bulk_set_config(int width, const shlc_bulk_config& c);
+
+shlc_bulk_config shlc_bulk_get_config(int width);
+
+const char* shlc_backend_name(shlc_backend b);
+
+#endif /* NEON_CIRCULAR_SHIFT_BULK_H */
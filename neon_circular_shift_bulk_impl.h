@@ -0,0 +1,101 @@
+#ifndef NEON_CIRCULAR_SHIFT_BULK_IMPL_H
+#define NEON_CIRCULAR_SHIFT_BULK_IMPL_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <chrono>
+#include <utility>
+
+#if defined(NEON_CIRCULAR_SHIFT_STATS) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#endif
+
+// Shared by the backends of neon_circular_shift_bulk.cpp, which are built in
+// their own translation units with the flags of their extension.
+
+// prefetch: how far ahead of the loads to prefetch, in bytes; 0 for none.
+template<typename T>
+using shlc_bulk_kernel = void (*)(const T* src, T* dst, size_t len, size_t prefetch);
+
+template<typename T>
+T shlc_bulk_rotl(T v, int n)
+{
+  static const int kBits = 8 * sizeof(T);
+  return static_cast<T>((v << n) | (v >> (kBits - n)));
+}
+
+static inline void shlc_bulk_prefetch(const void* p, size_t prefetch)
+{
+  if (prefetch) {
+    __builtin_prefetch(static_cast<const char*>(p) + prefetch);
+  }
+}
+
+namespace shlc_bulk_detail {
+
+template<typename T, template<typename, int> class K, int... ns>
+const shlc_bulk_kernel<T>* table(std::integer_sequence<int, ns...>)
+{
+  static const shlc_bulk_kernel<T> kKernels[] = { &K<T, ns + 1>::run... };
+  return kKernels;
+}
+
+} // namespace shlc_bulk_detail
+
+// K<T, n>::run for n = 1 .. bits - 1, at index n - 1.
+template<typename T, template<typename, int> class K>
+const shlc_bulk_kernel<T>* shlc_bulk_table()
+{
+  return shlc_bulk_detail::table<T, K>(std::make_integer_sequence<int, 8 * sizeof(T) - 1>());
+}
+
+#if defined(NEON_CIRCULAR_SHIFT_STATS)
+static inline uint64_t shlc_bulk_ticks()
+{
+#if defined(__aarch64__)
+  uint64_t t;
+  __asm__ volatile("mrs %0, cntvct_el0" : "=r"(t));
+  return t;
+#elif defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  const auto t = std::chrono::steady_clock::now().time_since_epoch();
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t).count());
+#endif
+}
+
+// Adds one call to the counters of the calling thread.
+void shlc_bulk_stats_record(int width, int n, size_t elems, uint64_t ticks);
+
+// Counts the call it lives in.
+class shlc_bulk_stats_scope {
+public:
+  shlc_bulk_stats_scope(int width, int n, size_t elems)
+    : width_(width), n_(n), elems_(elems), start_(shlc_bulk_ticks())
+  {
+  }
+
+  ~shlc_bulk_stats_scope()
+  {
+    shlc_bulk_stats_record(width_, n_, elems_, shlc_bulk_ticks() - start_);
+  }
+
+private:
+  int width_;
+  int n_;
+  size_t elems_;
+  uint64_t start_;
+};
+#endif
+
+#if defined(NEON_CIRCULAR_SHIFT_BULK_SHA3)
+const shlc_bulk_kernel<uint64_t>* shlc_bulk_sha3_u64();
+#endif
+
+#if defined(NEON_CIRCULAR_SHIFT_BULK_SVE2)
+template<typename T>
+const shlc_bulk_kernel<T>* shlc_bulk_sve2();
+#endif
+
+#endif /* NEON_CIRCULAR_SHIFT_BULK_IMPL_H */
@@ -0,0 +1,35 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <arm_neon.h>
+
+#include "neon_circular_shift_bulk_impl.h"
+
+// Built with -march=armv8.2-a+sha3; only called when HWCAP_SHA3 is set.
+
+namespace {
+
+// XAR rotates a ^ b right, so XAR with zero rotates left by 64 - n in one
+// instruction instead of a shift and an insert.
+template<typename T, int n>
+struct xar_kernel {
+  static void run(const uint64_t* src, uint64_t* dst, size_t len, size_t prefetch)
+  {
+    const auto zero = vdupq_n_u64(0);
+    size_t i = 0;
+    for (; i + 2 <= len; i += 2) {
+      shlc_bulk_prefetch(src + i, prefetch);
+      vst1q_u64(dst + i, vxarq_u64(vld1q_u64(src + i), zero, 64 - n));
+    }
+    for (; i < len; ++i) {
+      dst[i] = shlc_bulk_rotl(src[i], n);
+    }
+  }
+};
+
+} // namespace
+
+const shlc_bulk_kernel<uint64_t>* shlc_bulk_sha3_u64()
+{
+  return shlc_bulk_table<uint64_t, xar_kernel>();
+}
@@ -0,0 +1,87 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <arm_sve.h>
+
+#include "neon_circular_shift_bulk_impl.h"
+
+// Built with -march=armv8.2-a+sve2; only called when HWCAP2_SVE2 is set.
+
+namespace {
+
+template<typename T>
+svbool_t while_lt(uint64_t i, uint64_t n);
+
+template<>
+svbool_t while_lt<uint8_t>(uint64_t i, uint64_t n)
+{
+  return svwhilelt_b8_u64(i, n);
+}
+
+template<>
+svbool_t while_lt<uint16_t>(uint64_t i, uint64_t n)
+{
+  return svwhilelt_b16_u64(i, n);
+}
+
+template<>
+svbool_t while_lt<uint32_t>(uint64_t i, uint64_t n)
+{
+  return svwhilelt_b32_u64(i, n);
+}
+
+template<>
+svbool_t while_lt<uint64_t>(uint64_t i, uint64_t n)
+{
+  return svwhilelt_b64_u64(i, n);
+}
+
+svuint8_t zero(uint8_t)
+{
+  return svdup_n_u8(0);
+}
+
+svuint16_t zero(uint16_t)
+{
+  return svdup_n_u16(0);
+}
+
+svuint32_t zero(uint32_t)
+{
+  return svdup_n_u32(0);
+}
+
+svuint64_t zero(uint64_t)
+{
+  return svdup_n_u64(0);
+}
+
+// XAR with zero rotates right by bits - n. The predicate of the last
+// iteration covers the tail, so there is no scalar loop.
+template<typename T, int n>
+struct xar_kernel {
+  static void run(const T* src, T* dst, size_t len, size_t prefetch)
+  {
+    static const int kBits = 8 * sizeof(T);
+    const auto z = zero(T());
+    const auto lanes = svcntb() / sizeof(T);
+    for (uint64_t i = 0; i < len; i += lanes) {
+      shlc_bulk_prefetch(src + i, prefetch);
+      const auto pg = while_lt<T>(i, len);
+      svst1(pg, dst + i, svxar(svld1(pg, src + i), z, kBits - n));
+    }
+  }
+};
+
+} // namespace
+
+template<typename T>
+const shlc_bulk_kernel<T>* shlc_bulk_sve2()
+{
+  return shlc_bulk_table<T, xar_kernel>();
+}
+
+template const shlc_bulk_kernel<uint8_t>* shlc_bulk_sve2<uint8_t>();
+template const shlc_bulk_kernel<uint16_t>* shlc_bulk_sve2<uint16_t>();
+template const shlc_bulk_kernel<uint32_t>* shlc_bulk_sve2<uint32_t>();
+template const shlc_bulk_kernel<uint64_t>* shlc_bulk_sve2<uint64_t>();
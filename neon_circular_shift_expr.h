@@ -0,0 +1,226 @@
+#ifndef NEON_CIRCULAR_SHIFT_EXPR_H
+#define NEON_CIRCULAR_SHIFT_EXPR_H
+
+#include <arm_neon.h>
+
+#include <type_traits>
+#include <utility>
+
+#include "neon_circular_shift.h"
+
+// Lazy rotations. rotl(rotl(v, a), b) == rotl(v, (a + b) mod w), so a chain
+// of rotations is folded into one count and evaluated with a single
+// vshlc(q)_n_* call, or with none when the count is a multiple of the lane
+// width:
+//
+//   const uint32x4_t r = vshlc_lazy(v).rotl<5>().rotr<9>().rotl<4>();  // v
+//   const uint32x4_t s = vshlc_lazy(v).rotl<5>().rotl(k);               // one call
+//   const uint32x4_t t = vshlc_fold<5, 13, 7>(v);                       // <25>
+//
+// Compile-time counts fold at compile time. Once a run-time count joins the
+// chain the sum is kept in an int and evaluated through a table of the
+// vshlc(q)_n_* specializations; vshlc_fn(n) returns the table entry, so a
+// loop can look it up once.
+
+template<typename V>
+struct vshlc_traits;
+
+#define VSHLC_TRAITS(V, bits, func) \
+  template<>                        \
+  struct vshlc_traits<V> {          \
+    static const int kBits = bits;  \
+    template<int n>                 \
+    static V rotl(V v)              \
+    {                               \
+      return func<n>(v);            \
+    }                               \
+  };
+
+VSHLC_TRAITS(uint8x8_t, 8, vshlc_n_u8)
+VSHLC_TRAITS(uint16x4_t, 16, vshlc_n_u16)
+VSHLC_TRAITS(uint32x2_t, 32, vshlc_n_u32)
+VSHLC_TRAITS(uint64x1_t, 64, vshlc_n_u64)
+VSHLC_TRAITS(uint8x16_t, 8, vshlcq_n_u8)
+VSHLC_TRAITS(uint16x8_t, 16, vshlcq_n_u16)
+VSHLC_TRAITS(uint32x4_t, 32, vshlcq_n_u32)
+VSHLC_TRAITS(uint64x2_t, 64, vshlcq_n_u64)
+
+#undef VSHLC_TRAITS
+
+// n modulo the lane width of V, in [0, width).
+template<typename V>
+constexpr int vshlc_wrap(int n)
+{
+  return ((n % vshlc_traits<V>::kBits) + vshlc_traits<V>::kBits) % vshlc_traits<V>::kBits;
+}
+
+template<typename V>
+using vshlc_rotl_fn = V (*)(V);
+
+namespace vshlc_expr_detail {
+
+template<typename V, int n>
+V rotl(V v, std::false_type)
+{
+  return vshlc_traits<V>::template rotl<n>(v);
+}
+
+template<typename V, int n>
+V rotl(V v, std::true_type)
+{
+  return v;
+}
+
+template<typename V, int n>
+V rotl(V v)
+{
+  return rotl<V, n>(v, std::integral_constant<bool, n == 0>());
+}
+
+template<typename V, int... ns>
+vshlc_rotl_fn<V> table(std::integer_sequence<int, ns...>, int n)
+{
+  static const vshlc_rotl_fn<V> kRotl[] = { &rotl<V, ns>... };
+  return kRotl[n];
+}
+
+} // namespace vshlc_expr_detail
+
+// The single rotation by n (any int) for V.
+template<typename V>
+vshlc_rotl_fn<V> vshlc_fn(int n)
+{
+  return vshlc_expr_detail::table<V>(std::make_integer_sequence<int, vshlc_traits<V>::kBits>(), vshlc_wrap<V>(n));
+}
+
+// v rotated left by a run-time count n, already in [0, width).
+template<typename V>
+class vshlc_expr_rt {
+public:
+  vshlc_expr_rt(V v, int n) : v_(v), n_(n)
+  {
+  }
+
+  template<int m>
+  vshlc_expr_rt rotl() const
+  {
+    return vshlc_expr_rt(v_, vshlc_wrap<V>(n_ + m % vshlc_traits<V>::kBits));
+  }
+
+  template<int m>
+  vshlc_expr_rt rotr() const
+  {
+    return rotl<-m>();
+  }
+
+  vshlc_expr_rt rotl(int m) const
+  {
+    return vshlc_expr_rt(v_, vshlc_wrap<V>(n_ + vshlc_wrap<V>(m)));
+  }
+
+  vshlc_expr_rt rotr(int m) const
+  {
+    return rotl(-vshlc_wrap<V>(m));
+  }
+
+  int count() const
+  {
+    return n_;
+  }
+
+  V eval() const
+  {
+    return vshlc_fn<V>(n_)(v_);
+  }
+
+  operator V() const
+  {
+    return eval();
+  }
+
+private:
+  V v_;
+  int n_;
+};
+
+// v rotated left by n, folded at compile time.
+template<typename V, int n>
+class vshlc_expr {
+  static_assert(n >= 0 && n < vshlc_traits<V>::kBits, "n is kept modulo the lane width");
+
+public:
+  explicit vshlc_expr(V v) : v_(v)
+  {
+  }
+
+  template<int m>
+  vshlc_expr<V, vshlc_wrap<V>(n + m % vshlc_traits<V>::kBits)> rotl() const
+  {
+    return vshlc_expr<V, vshlc_wrap<V>(n + m % vshlc_traits<V>::kBits)>(v_);
+  }
+
+  template<int m>
+  vshlc_expr<V, vshlc_wrap<V>(n - m % vshlc_traits<V>::kBits)> rotr() const
+  {
+    return vshlc_expr<V, vshlc_wrap<V>(n - m % vshlc_traits<V>::kBits)>(v_);
+  }
+
+  vshlc_expr_rt<V> rotl(int m) const
+  {
+    return vshlc_expr_rt<V>(v_, n).rotl(m);
+  }
+
+  vshlc_expr_rt<V> rotr(int m) const
+  {
+    return vshlc_expr_rt<V>(v_, n).rotr(m);
+  }
+
+  static constexpr int count()
+  {
+    return n;
+  }
+
+  V eval() const
+  {
+    return vshlc_expr_detail::rotl<V, n>(v_);
+  }
+
+  operator V() const
+  {
+    return eval();
+  }
+
+private:
+  V v_;
+};
+
+template<typename V>
+vshlc_expr<V, 0> vshlc_lazy(V v)
+{
+  return vshlc_expr<V, 0>(v);
+}
+
+namespace vshlc_expr_detail {
+
+template<typename V>
+constexpr int sum()
+{
+  return 0;
+}
+
+template<typename V, int n, int... ns>
+constexpr int sum()
+{
+  return vshlc_wrap<V>(n % vshlc_traits<V>::kBits + sum<V, ns...>());
+}
+
+} // namespace vshlc_expr_detail
+
+// rotl(... rotl(rotl(v, n0), n1) ..., nk) as one rotation.
+template<int... ns, typename V>
+V vshlc_fold(V v)
+{
+  return vshlc_expr_detail::rotl<V, vshlc_expr_detail::sum<V, ns...>()>(v);
+}
+
+#endif /* NEON_CIRCULAR_SHIFT_EXPR_H */
@@ -0,0 +1,249 @@
+#ifndef NEON_CIRCULAR_SHIFT_PIPELINE_H
+#define NEON_CIRCULAR_SHIFT_PIPELINE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <arm_neon.h>
+
+#include <tuple>
+#include <utility>
+
+#include "neon_circular_shift_expr.h"
+
+// Element-wise pipelines of rotations and XOR, add and AND with a constant
+// or with a stream, run in one pass over the buffer: each Q vector is loaded
+// once, goes through every stage in registers and is stored once.
+//
+//   const auto p = shlc_pipeline<uint32_t>().rotl<5>().eor_stream(key).add(0x9e3779b9);
+//   p.run(src, dst, len);  // dst[i] = (rotl(src[i], 5) ^ key[i]) + 0x9e3779b9
+//
+// A stream is read at the same index as the source. dst may be src, and a
+// stream may be src or dst; otherwise the buffers must not overlap. The
+// stages are fixed at compile time, so the loop has no dispatch.
+
+template<typename T>
+struct shlc_lanes;
+
+#define SHLC_LANES(T, V, suffix)    \
+  template<>                        \
+  struct shlc_lanes<T> {            \
+    typedef V vec;                  \
+    static V load(const T* p)       \
+    {                               \
+      return vld1q_##suffix(p);     \
+    }                               \
+    static void store(T* p, V v)    \
+    {                               \
+      vst1q_##suffix(p, v);         \
+    }                               \
+    static V dup(T c)               \
+    {                               \
+      return vdupq_n_##suffix(c);   \
+    }                               \
+    static V eor(V a, V b)          \
+    {                               \
+      return veorq_##suffix(a, b);  \
+    }                               \
+    static V add(V a, V b)          \
+    {                               \
+      return vaddq_##suffix(a, b);  \
+    }                               \
+    static V mask(V a, V b)         \
+    {                               \
+      return vandq_##suffix(a, b);  \
+    }                               \
+  };
+
+SHLC_LANES(uint8_t, uint8x16_t, u8)
+SHLC_LANES(uint16_t, uint16x8_t, u16)
+SHLC_LANES(uint32_t, uint32x4_t, u32)
+SHLC_LANES(uint64_t, uint64x2_t, u64)
+
+#undef SHLC_LANES
+
+namespace shlc_pipeline_detail {
+
+// Each stage maps a vector at element index i, or one element for the tail.
+template<typename T, int n>
+struct rotl {
+  typedef typename shlc_lanes<T>::vec V;
+
+  V operator()(V v, size_t) const
+  {
+    return vshlc_fold<n>(v);
+  }
+
+  T operator()(T v, size_t) const
+  {
+    return n == 0 ? v : static_cast<T>((v << n) | (v >> (8 * sizeof(T) - n)));
+  }
+};
+
+// op(x, c) with a constant c.
+template<typename T, typename Op>
+struct with_const {
+  typedef typename shlc_lanes<T>::vec V;
+  T c;
+
+  V operator()(V v, size_t) const
+  {
+    return Op::vec(v, shlc_lanes<T>::dup(c));
+  }
+
+  T operator()(T v, size_t) const
+  {
+    return Op::scalar(v, c);
+  }
+};
+
+// op(x, s[i]) with a stream s.
+template<typename T, typename Op>
+struct with_stream {
+  typedef typename shlc_lanes<T>::vec V;
+  const T* s;
+
+  V operator()(V v, size_t i) const
+  {
+    return Op::vec(v, shlc_lanes<T>::load(s + i));
+  }
+
+  T operator()(T v, size_t i) const
+  {
+    return Op::scalar(v, s[i]);
+  }
+};
+
+template<typename T>
+struct eor {
+  typedef typename shlc_lanes<T>::vec V;
+
+  static V vec(V a, V b)
+  {
+    return shlc_lanes<T>::eor(a, b);
+  }
+
+  static T scalar(T a, T b)
+  {
+    return a ^ b;
+  }
+};
+
+template<typename T>
+struct add {
+  typedef typename shlc_lanes<T>::vec V;
+
+  static V vec(V a, V b)
+  {
+    return shlc_lanes<T>::add(a, b);
+  }
+
+  static T scalar(T a, T b)
+  {
+    return static_cast<T>(a + b);
+  }
+};
+
+template<typename T>
+struct mask {
+  typedef typename shlc_lanes<T>::vec V;
+
+  static V vec(V a, V b)
+  {
+    return shlc_lanes<T>::mask(a, b);
+  }
+
+  static T scalar(T a, T b)
+  {
+    return a & b;
+  }
+};
+
+} // namespace shlc_pipeline_detail
+
+template<typename T, typename... Stages>
+class shlc_pipeline {
+public:
+  shlc_pipeline()
+  {
+  }
+
+  explicit shlc_pipeline(const std::tuple<Stages...>& stages) : stages_(stages)
+  {
+  }
+
+  template<int n>
+  auto rotl() const
+  {
+    return then(shlc_pipeline_detail::rotl<T, ((n % kBits) + kBits) % kBits>());
+  }
+
+  template<int n>
+  auto rotr() const
+  {
+    return rotl<-(n % kBits)>();
+  }
+
+  auto eor(T c) const
+  {
+    return then(shlc_pipeline_detail::with_const<T, shlc_pipeline_detail::eor<T>>{ c });
+  }
+
+  auto add(T c) const
+  {
+    return then(shlc_pipeline_detail::with_const<T, shlc_pipeline_detail::add<T>>{ c });
+  }
+
+  auto mask(T c) const
+  {
+    return then(shlc_pipeline_detail::with_const<T, shlc_pipeline_detail::mask<T>>{ c });
+  }
+
+  auto eor_stream(const T* s) const
+  {
+    return then(shlc_pipeline_detail::with_stream<T, shlc_pipeline_detail::eor<T>>{ s });
+  }
+
+  auto add_stream(const T* s) const
+  {
+    return then(shlc_pipeline_detail::with_stream<T, shlc_pipeline_detail::add<T>>{ s });
+  }
+
+  auto mask_stream(const T* s) const
+  {
+    return then(shlc_pipeline_detail::with_stream<T, shlc_pipeline_detail::mask<T>>{ s });
+  }
+
+  void run(const T* src, T* dst, size_t len) const
+  {
+    typedef shlc_lanes<T> L;
+    static const size_t kLanes = 16 / sizeof(T);
+    size_t i = 0;
+    for (; i + kLanes <= len; i += kLanes) {
+      L::store(dst + i, apply(L::load(src + i), i, std::index_sequence_for<Stages...>()));
+    }
+    for (; i < len; ++i) {
+      dst[i] = apply(src[i], i, std::index_sequence_for<Stages...>());
+    }
+  }
+
+private:
+  static const int kBits = 8 * sizeof(T);
+
+  template<typename Stage>
+  shlc_pipeline<T, Stages..., Stage> then(const Stage& s) const
+  {
+    return shlc_pipeline<T, Stages..., Stage>(std::tuple_cat(stages_, std::make_tuple(s)));
+  }
+
+  template<typename X, size_t... k>
+  X apply(X v, [[maybe_unused]] size_t i, std::index_sequence<k...>) const
+  {
+    ((v = std::get<k>(stages_)(v, i)), ...);
+    return v;
+  }
+
+  std::tuple<Stages...> stages_;
+};
+
+#endif /* NEON_CIRCULAR_SHIFT_PIPELINE_H */
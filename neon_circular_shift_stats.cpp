@@ -0,0 +1,219 @@
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "neon_circular_shift_bulk_impl.h"
+#include "neon_circular_shift_stats.h"
+
+#if defined(NEON_CIRCULAR_SHIFT_STATS)
+
+namespace {
+
+const int kWidths[] = { 8, 16, 32, 64 };
+// One slot per width and shift count: 8 + 16 + 32 + 64.
+const int kSlots = 120;
+
+int slot(int width, int n)
+{
+  return width - 8 + n;
+}
+
+// Written only by the owning thread; atomic so that snapshots can read it.
+struct counters {
+  std::atomic<uint64_t> calls{0};
+  std::atomic<uint64_t> elems{0};
+  std::atomic<uint64_t> ticks{0};
+};
+
+struct block {
+  counters c[kSlots];
+};
+
+void add(std::atomic<uint64_t>* a, uint64_t v)
+{
+  a->store(a->load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+}
+
+// The blocks of running threads, and the sums of those that have exited.
+// Never destroyed, so that threads may exit during static destruction.
+struct registry {
+  std::mutex m;
+  std::vector<const block*> live;
+  block retired;
+};
+
+registry& reg()
+{
+  static registry* r = new registry;
+  return *r;
+}
+
+struct thread_block {
+  block b;
+
+  thread_block()
+  {
+    std::lock_guard<std::mutex> lock(reg().m);
+    reg().live.push_back(&b);
+  }
+
+  ~thread_block()
+  {
+    auto& r = reg();
+    std::lock_guard<std::mutex> lock(r.m);
+    for (int i = 0; i < kSlots; ++i) {
+      add(&r.retired.c[i].calls, b.c[i].calls.load(std::memory_order_relaxed));
+      add(&r.retired.c[i].elems, b.c[i].elems.load(std::memory_order_relaxed));
+      add(&r.retired.c[i].ticks, b.c[i].ticks.load(std::memory_order_relaxed));
+    }
+    for (auto& p : r.live) {
+      if (p == &b) {
+        p = r.live.back();
+        r.live.pop_back();
+        break;
+      }
+    }
+  }
+};
+
+thread_local thread_block tls;
+
+} // namespace
+
+void shlc_bulk_stats_record(int width, int n, size_t elems, uint64_t ticks)
+{
+  auto& c = tls.b.c[slot(width, n)];
+  add(&c.calls, 1);
+  add(&c.elems, elems);
+  add(&c.ticks, ticks);
+}
+
+bool shlc_bulk_stats_enabled()
+{
+  return true;
+}
+
+std::vector<shlc_bulk_stat> shlc_bulk_stats_snapshot()
+{
+  std::vector<shlc_bulk_stat> out;
+  auto& r = reg();
+  std::lock_guard<std::mutex> lock(r.m);
+  for (const auto width : kWidths) {
+    for (int n = 0; n < width; ++n) {
+      const auto i = slot(width, n);
+      shlc_bulk_stat s = { width, n, 0, 0, 0 };
+      for (const block* b : r.live) {
+        s.calls += b->c[i].calls.load(std::memory_order_relaxed);
+        s.elems += b->c[i].elems.load(std::memory_order_relaxed);
+        s.ticks += b->c[i].ticks.load(std::memory_order_relaxed);
+      }
+      s.calls += r.retired.c[i].calls.load(std::memory_order_relaxed);
+      s.elems += r.retired.c[i].elems.load(std::memory_order_relaxed);
+      s.ticks += r.retired.c[i].ticks.load(std::memory_order_relaxed);
+      if (s.calls) {
+        out.push_back(s);
+      }
+    }
+  }
+  return out;
+}
+
+const char* shlc_bulk_stats_clock()
+{
+#if defined(__aarch64__)
+  return "cntvct";
+#elif defined(__x86_64__) || defined(__i386__)
+  return "tsc";
+#else
+  return "ns";
+#endif
+}
+
+double shlc_bulk_stats_ticks_per_second()
+{
+#if defined(__aarch64__)
+  uint64_t f;
+  __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(f));
+  return static_cast<double>(f);
+#elif defined(__x86_64__) || defined(__i386__)
+  static const double kRate = []() {
+    typedef std::chrono::steady_clock clock;
+    const auto t0 = clock::now();
+    const auto c0 = shlc_bulk_ticks();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const auto c1 = shlc_bulk_ticks();
+    const auto t1 = clock::now();
+    return (c1 - c0) / std::chrono::duration<double>(t1 - t0).count();
+  }();
+  return kRate;
+#else
+  return 1e9;
+#endif
+}
+
+#else
+
+bool shlc_bulk_stats_enabled()
+{
+  return false;
+}
+
+std::vector<shlc_bulk_stat> shlc_bulk_stats_snapshot()
+{
+  return {};
+}
+
+const char* shlc_bulk_stats_clock()
+{
+  return "none";
+}
+
+double shlc_bulk_stats_ticks_per_second()
+{
+  return 0;
+}
+
+#endif
+
+std::string shlc_bulk_stats_text()
+{
+  const auto stats = shlc_bulk_stats_snapshot();
+  const auto rate = shlc_bulk_stats_ticks_per_second();
+  char buf[256];
+  snprintf(buf, sizeof(buf), "clock %s %.0f ticks/s\n", shlc_bulk_stats_clock(), rate);
+  std::string out = buf;
+  for (const auto& s : stats) {
+    snprintf(buf, sizeof(buf),
+             "u%d n=%d calls=%" PRIu64 " elems=%" PRIu64 " bytes=%" PRIu64 " ticks=%" PRIu64 " ns=%.0f\n",
+             s.width, s.n, s.calls, s.elems, s.elems * s.width / 8, s.ticks, rate ? s.ticks * 1e9 / rate : 0.0);
+    out += buf;
+  }
+  return out;
+}
+
+std::string shlc_bulk_stats_json()
+{
+  const auto stats = shlc_bulk_stats_snapshot();
+  const auto rate = shlc_bulk_stats_ticks_per_second();
+  char buf[256];
+  snprintf(buf, sizeof(buf), "{\"clock\": \"%s\", \"ticks_per_second\": %.0f, \"kernels\": [",
+           shlc_bulk_stats_clock(), rate);
+  std::string out = buf;
+  for (size_t i = 0; i < stats.size(); ++i) {
+    const auto& s = stats[i];
+    snprintf(buf, sizeof(buf),
+             "%s\n  {\"width\": %d, \"n\": %d, \"calls\": %" PRIu64 ", \"elems\": %" PRIu64
+             ", \"bytes\": %" PRIu64 ", \"ticks\": %" PRIu64 "}",
+             i ? "," : "", s.width, s.n, s.calls, s.elems, s.elems * s.width / 8, s.ticks);
+    out += buf;
+  }
+  out += stats.empty() ? "]}\n" : "\n]}\n";
+  return out;
+}
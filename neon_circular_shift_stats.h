@@ -0,0 +1,47 @@
+#ifndef NEON_CIRCULAR_SHIFT_STATS_H
+#define NEON_CIRCULAR_SHIFT_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+// Counters of the bulk rotations (neon_circular_shift_bulk.h), for a metrics
+// exporter to poll. Built only with -DNEON_CIRCULAR_SHIFT_STATS (cmake
+// -DMY_STATS=ON); otherwise the bulk functions carry no instrumentation and
+// the snapshots are empty.
+//
+// Each thread counts its own calls, elements and ticks per width and shift
+// count, without locks or shared cache lines; a snapshot sums the threads,
+// those that have exited included. The counts only grow, so an exporter
+// reports them as counters and takes differences itself.
+//
+// Ticks come from CNTVCT_EL0 on AArch64, the TSC on x86 and the monotonic
+// clock in ns elsewhere (ARMv7 kernels need not give user space the
+// virtual counter). A call is timed as a whole, worker threads included.
+
+struct shlc_bulk_stat {
+  int width;
+  int n;
+  uint64_t calls;
+  uint64_t elems;
+  uint64_t ticks;
+};
+
+bool shlc_bulk_stats_enabled();
+
+// Every (width, n) that has been called, in order of width and n.
+std::vector<shlc_bulk_stat> shlc_bulk_stats_snapshot();
+
+// "cntvct", "tsc" or "ns", and the ticks per second (the TSC is measured
+// against the monotonic clock once).
+const char* shlc_bulk_stats_clock();
+double shlc_bulk_stats_ticks_per_second();
+
+// The snapshot as lines of "u32 n=5 calls=... elems=... bytes=... ticks=...
+// ns=..." after a "clock" line, or as one JSON object.
+std::string shlc_bulk_stats_text();
+std::string shlc_bulk_stats_json();
+
+#endif /* NEON_CIRCULAR_SHIFT_STATS_H */
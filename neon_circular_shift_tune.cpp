@@ -0,0 +1,239 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "neon_circular_shift_bulk.h"
+#include "neon_circular_shift_tune.h"
+
+namespace {
+
+const int kWidths[] = { 8, 16, 32, 64 };
+
+std::string trim(const std::string& s)
+{
+  const auto b = s.find_first_not_of(" \t");
+  const auto e = s.find_last_not_of(" \t\r\n");
+  return b == std::string::npos ? std::string() : s.substr(b, e - b + 1);
+}
+
+void rotate(int width, void* buf, size_t bytes)
+{
+  // A generic shift count; the byte and half-width ones take other paths
+  // but have the same loads and stores.
+  const int n = 3;
+  switch (width) {
+  case 8:
+    shlc_bulk_u8(static_cast<uint8_t*>(buf), static_cast<uint8_t*>(buf), bytes, n);
+    break;
+  case 16:
+    shlc_bulk_u16(static_cast<uint16_t*>(buf), static_cast<uint16_t*>(buf), bytes / 2, n);
+    break;
+  case 32:
+    shlc_bulk_u32(static_cast<uint32_t*>(buf), static_cast<uint32_t*>(buf), bytes / 4, n);
+    break;
+  case 64:
+    shlc_bulk_u64(static_cast<uint64_t*>(buf), static_cast<uint64_t*>(buf), bytes / 8, n);
+    break;
+  }
+}
+
+// Best of 3 runs of at least min_time_ms, in ns per call.
+double measure(int width, const shlc_bulk_config& c, std::vector<uint64_t>* buf,
+               const shlc_tune_options& opt)
+{
+  typedef std::chrono::steady_clock clock;
+  shlc_bulk_set_config(width, c);
+  const auto bytes = buf->size() * sizeof(uint64_t);
+  rotate(width, buf->data(), bytes);
+  double best = 0;
+  for (int r = 0; r < 3; ++r) {
+    uint64_t calls = 0;
+    const auto start = clock::now();
+    double ns = 0;
+    do {
+      rotate(width, buf->data(), bytes);
+      ++calls;
+      ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    } while (ns < opt.min_time_ms * 1e6);
+    const auto per_call = ns / calls;
+    best = r == 0 ? per_call : std::min(best, per_call);
+  }
+  return best;
+}
+
+void print_config(FILE* log, int width, const shlc_bulk_config& c, double ns)
+{
+  if (log) {
+    fprintf(log, "u%-2d %-4s %s unroll %d prefetch %zu chunk %zu: %.1f ns\n", width,
+            shlc_backend_name(shlc_bulk_backend(width)), c.q ? "q" : "d", c.unroll, c.prefetch, c.chunk, ns);
+  }
+}
+
+} // namespace
+
+void shlc_bulk_autotune(const shlc_tune_options& opt, FILE* log)
+{
+  std::vector<uint64_t> buf(std::max<size_t>(opt.bytes / sizeof(uint64_t), 1));
+  for (size_t i = 0; i < buf.size(); ++i) {
+    buf[i] = i * 0x9e3779b97f4a7c15ull;
+  }
+  const auto bytes = buf.size() * sizeof(uint64_t);
+  const auto cores = std::thread::hardware_concurrency();
+
+  for (const auto width : kWidths) {
+    // The search is for the kernels of cached buffers; the streaming ones
+    // keep their defaults.
+    auto best = shlc_bulk_config();
+    best.stream = SIZE_MAX;
+    auto best_ns = measure(width, best, &buf, opt);
+    const auto attempt = [&](const shlc_bulk_config& c) {
+      const auto ns = measure(width, c, &buf, opt);
+      if (ns < best_ns * 0.97) {
+        best = c;
+        best_ns = ns;
+      }
+    };
+
+    if (shlc_bulk_backend(width) == shlc_backend::neon) {
+      const auto base = best;
+      for (const auto q : { false, true }) {
+        for (const auto unroll : { 1, 2, 4, 8 }) {
+          auto c = base;
+          c.q = q;
+          c.unroll = unroll;
+          attempt(c);
+        }
+      }
+    }
+    for (const size_t prefetch : { 128, 256, 512, 1024 }) {
+      auto c = best;
+      c.prefetch = prefetch;
+      attempt(c);
+    }
+    if (cores > 1) {
+      for (const size_t chunk : { 64 << 10, 256 << 10, 1 << 20 }) {
+        if (chunk * 2 <= bytes) {
+          auto c = best;
+          c.chunk = chunk;
+          attempt(c);
+        }
+      }
+    }
+    best.stream = shlc_bulk_config().stream;
+    shlc_bulk_set_config(width, best);
+    print_config(log, width, best, best_ns);
+  }
+}
+
+std::string shlc_bulk_tuning_key()
+{
+#if defined(__aarch64__)
+  std::string key = "aarch64";
+#elif defined(__arm__)
+  std::string key = "arm";
+#else
+  std::string key = "other";
+#endif
+  std::ifstream f("/proc/cpuinfo");
+  std::string line, model, implementer;
+  std::set<std::string> cores;
+  while (std::getline(f, line)) {
+    const auto colon = line.find(':');
+    if (colon == std::string::npos) {
+      continue;
+    }
+    const auto k = trim(line.substr(0, colon));
+    const auto v = trim(line.substr(colon + 1));
+    if (k == "model name" && model.empty()) {
+      model = v;
+    } else if (k == "CPU implementer") {
+      implementer = v;
+    } else if (k == "CPU part") {
+      cores.insert(implementer + ":" + v);
+    }
+  }
+  if (cores.empty()) {
+    cores.insert(model.empty() ? "unknown" : model);
+  }
+  for (const auto& c : cores) {
+    key += " " + c;
+  }
+  return key;
+}
+
+bool shlc_bulk_save_tuning(const std::string& path)
+{
+  const auto key = shlc_bulk_tuning_key();
+  // Keep the sections of other machines.
+  std::vector<std::string> kept;
+  {
+    std::ifstream in(path);
+    std::string line;
+    bool skip = false;
+    while (std::getline(in, line)) {
+      if (line.compare(0, 4, "key ") == 0) {
+        skip = line.substr(4) == key;
+      }
+      if (!skip) {
+        kept.push_back(line);
+      }
+    }
+  }
+  FILE* f = fopen(path.c_str(), "w");
+  if (!f) {
+    return false;
+  }
+  for (const auto& line : kept) {
+    fprintf(f, "%s\n", line.c_str());
+  }
+  fprintf(f, "key %s\n", key.c_str());
+  fprintf(f, "# width q unroll prefetch chunk stream stream_prefetch aligned\n");
+  for (const auto width : kWidths) {
+    const auto c = shlc_bulk_get_config(width);
+    fprintf(f, "%d %d %d %zu %zu %zu %zu %d\n", width, c.q ? 1 : 0, c.unroll, c.prefetch, c.chunk, c.stream,
+            c.stream_prefetch, c.aligned ? 1 : 0);
+  }
+  return fclose(f) == 0;
+}
+
+bool shlc_bulk_load_tuning(const std::string& path)
+{
+  const auto key = shlc_bulk_tuning_key();
+  std::ifstream in(path);
+  std::string line;
+  bool found = false;
+  bool section = false;
+  while (std::getline(in, line)) {
+    if (line.compare(0, 4, "key ") == 0) {
+      section = line.substr(4) == key;
+      found |= section;
+      continue;
+    }
+    if (!section || line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream ss(line);
+    int width, q;
+    shlc_bulk_config c;
+    if (ss >> width >> q >> c.unroll >> c.prefetch >> c.chunk) {
+      // Files from before the streaming and aligned kernels end early.
+      int aligned = 1;
+      if (ss >> c.stream >> c.stream_prefetch) {
+        ss >> aligned;
+      }
+      c.q = q != 0;
+      c.aligned = aligned != 0;
+      shlc_bulk_set_config(width, c);
+    }
+  }
+  return found;
+}
@@ -0,0 +1,42 @@
+#ifndef NEON_CIRCULAR_SHIFT_TUNE_H
+#define NEON_CIRCULAR_SHIFT_TUNE_H
+
+#include <cstddef>
+#include <cstdio>
+
+#include <string>
+
+// Autotuner for the bulk rotations of neon_circular_shift_bulk.h. The best
+// register width, unroll depth, prefetch distance and thread share differ
+// between cores, so they are measured on the machine that runs the code:
+//
+//   shlc_bulk_autotune(shlc_tune_options(), stdout);
+//   shlc_bulk_save_tuning("tuning.txt");
+//
+// and reloaded at start-up with shlc_bulk_load_tuning(), or by setting
+// NEON_CIRCULAR_SHIFT_TUNING=tuning.txt before the first bulk call.
+//
+// A tuning file holds one section per machine (architecture of the build and
+// the implementer and part of every kind of core), so one file can be shared
+// by a fleet; saving replaces the section of the current machine.
+
+struct shlc_tune_options {
+  size_t bytes = 1 << 20;    // buffer rotated by each measurement
+  double min_time_ms = 10;   // per measurement
+};
+
+// Measures each width with its current backend and applies the fastest
+// configuration: D or Q and the unroll depth first, then the prefetch
+// distance, then the thread share, each starting from the best so far. A
+// candidate has to be 3% faster to win. Progress goes to log unless null.
+void shlc_bulk_autotune(const shlc_tune_options& opt, FILE* log);
+
+bool shlc_bulk_save_tuning(const std::string& path);
+
+// Applies the section of this machine; false when there is none.
+bool shlc_bulk_load_tuning(const std::string& path);
+
+// The key of this machine's section.
+std::string shlc_bulk_tuning_key();
+
+#endif /* NEON_CIRCULAR_SHIFT_TUNE_H */
@@ -0,0 +1,405 @@
+#ifndef NEON_COUNTER_RNG_H
+#define NEON_COUNTER_RNG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <arm_neon.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "neon_circular_shift.h"
+
+// Counter-based generators (Random123 Threefry-2x64-20, Threefry-4x32-20
+// and Philox-4x32-10). Block b of a stream is the encryption of the counter
+// {counter_start + b, 0, ...} under the key, so any position is reachable in
+// O(1): output word i lives in block i / kWords.
+// generate() writes the blocks in order, word 0 of a block first.
+
+namespace neon_counter_rng_detail {
+
+constexpr int kThreefry2x64Rot[8] = { 16, 42, 12, 31, 16, 32, 24, 21 };
+constexpr int kThreefry4x32Rot[8][2] = {
+  { 10, 26 }, { 11, 21 }, { 13, 27 }, { 23, 5 }, { 6, 20 }, { 17, 11 }, { 25, 10 }, { 18, 20 }
+};
+
+template<int r>
+static inline void threefry2x64_round(uint64x2_t* x0, uint64x2_t* x1)
+{
+  *x0 = vaddq_u64(*x0, *x1);
+  *x1 = vshlcq_n_u64<kThreefry2x64Rot[r % 8]>(*x1);
+  *x1 = veorq_u64(*x1, *x0);
+}
+
+// Four rounds followed by key injection g + 1.
+template<int g>
+static inline void threefry2x64_group(uint64x2_t* x0, uint64x2_t* x1, const uint64x2_t (*inj)[2])
+{
+  threefry2x64_round<4 * g + 0>(x0, x1);
+  threefry2x64_round<4 * g + 1>(x0, x1);
+  threefry2x64_round<4 * g + 2>(x0, x1);
+  threefry2x64_round<4 * g + 3>(x0, x1);
+  *x0 = vaddq_u64(*x0, inj[g + 1][0]);
+  *x1 = vaddq_u64(*x1, inj[g + 1][1]);
+}
+
+template<int r>
+static inline void threefry4x32_round(uint32x4_t* x)
+{
+  if (r % 2 == 0) {
+    x[0] = vaddq_u32(x[0], x[1]);
+    x[1] = veorq_u32(vshlcq_n_u32<kThreefry4x32Rot[r % 8][0]>(x[1]), x[0]);
+    x[2] = vaddq_u32(x[2], x[3]);
+    x[3] = veorq_u32(vshlcq_n_u32<kThreefry4x32Rot[r % 8][1]>(x[3]), x[2]);
+  } else {
+    x[0] = vaddq_u32(x[0], x[3]);
+    x[3] = veorq_u32(vshlcq_n_u32<kThreefry4x32Rot[r % 8][0]>(x[3]), x[0]);
+    x[2] = vaddq_u32(x[2], x[1]);
+    x[1] = veorq_u32(vshlcq_n_u32<kThreefry4x32Rot[r % 8][1]>(x[1]), x[2]);
+  }
+}
+
+template<int g>
+static inline void threefry4x32_group(uint32x4_t* x, const uint32x4_t (*inj)[4])
+{
+  threefry4x32_round<4 * g + 0>(x);
+  threefry4x32_round<4 * g + 1>(x);
+  threefry4x32_round<4 * g + 2>(x);
+  threefry4x32_round<4 * g + 3>(x);
+  for (int w = 0; w < 4; ++w) {
+    x[w] = vaddq_u32(x[w], inj[g + 1][w]);
+  }
+}
+
+static inline void mulhilo(uint32x4_t a, uint32x2_t m, uint32x4_t* hi, uint32x4_t* lo)
+{
+  const auto p0 = vreinterpretq_u32_u64(vmull_u32(vget_low_u32(a), m));
+  const auto p1 = vreinterpretq_u32_u64(vmull_u32(vget_high_u32(a), m));
+  const auto uz = vuzpq_u32(p0, p1);
+  *lo = uz.val[0];
+  *hi = uz.val[1];
+}
+
+// Generates a full iteration into a scratch buffer and copies the head when
+// fewer than kStep words are left.
+template<typename Gen, typename T>
+static inline void generate_tail(const Gen& gen, uint64_t counter, T* dst, size_t n)
+{
+  T tmp[Gen::kStep];
+  gen.generate_step(counter, tmp);
+  memcpy(dst, tmp, n * sizeof(T));
+}
+
+template<typename Gen, typename T>
+static inline void generate(const Gen& gen, uint64_t counter_start, T* dst, size_t n)
+{
+  const auto blocks_per_step = Gen::kStep / Gen::kWords;
+  size_t i = 0;
+  auto counter = counter_start;
+  for (; i + Gen::kStep <= n; i += Gen::kStep, counter += blocks_per_step) {
+    gen.generate_step(counter, dst + i);
+  }
+  if (i < n) {
+    generate_tail(gen, counter, dst + i, n - i);
+  }
+}
+
+static inline void to_unit_float(const uint32_t* src, float* dst, size_t n)
+{
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const auto v = vcvtq_f32_u32(vshrq_n_u32(vld1q_u32(src + i), 8));
+    vst1q_f32(dst + i, vmulq_n_f32(v, 1.0f / 16777216.0f));
+  }
+  for (; i < n; ++i) {
+    dst[i] = static_cast<float>(src[i] >> 8) * (1.0f / 16777216.0f);
+  }
+}
+
+// ARMv7 NEON has no double precision lanes.
+static inline void to_unit_double(const uint64_t* src, double* dst, size_t n)
+{
+  for (size_t i = 0; i < n; ++i) {
+    dst[i] = static_cast<double>(src[i] >> 11) * (1.0 / 9007199254740992.0);
+  }
+}
+
+template<typename Gen, typename T, typename F>
+static inline void generate_uniform(const Gen& gen, uint64_t counter_start, F* dst, size_t n,
+                                    void (*convert)(const T*, F*, size_t))
+{
+  static const size_t kChunk = 256;
+  T tmp[kChunk];
+  for (size_t i = 0; i < n; i += kChunk) {
+    const auto len = std::min(kChunk, n - i);
+    gen.generate(counter_start + i / Gen::kWords, tmp, len);
+    convert(tmp, dst + i, len);
+  }
+}
+
+} // namespace neon_counter_rng_detail
+
+class neon_threefry2x64 {
+public:
+  typedef uint64_t value_type;
+  static const int kWords = 2;
+  static const int kStep = 8;
+
+  neon_threefry2x64(uint64_t k0, uint64_t k1)
+  {
+    const uint64_t ks[3] = { k0, k1, 0x1BD11BDAA9FC1A22ULL ^ k0 ^ k1 };
+    for (int s = 0; s < 6; ++s) {
+      inj_[s][0] = ks[s % 3];
+      inj_[s][1] = ks[(s + 1) % 3] + s;
+    }
+  }
+
+  void block(const uint64_t* ctr, uint64_t* out) const
+  {
+    uint64x2_t inj[6][2];
+    load_injections(inj);
+    auto x0 = vaddq_u64(vdupq_n_u64(ctr[0]), inj[0][0]);
+    auto x1 = vaddq_u64(vdupq_n_u64(ctr[1]), inj[0][1]);
+    rounds(&x0, &x1, inj);
+    out[0] = vgetq_lane_u64(x0, 0);
+    out[1] = vgetq_lane_u64(x1, 0);
+  }
+
+  void generate(uint64_t counter_start, uint64_t* dst, size_t n) const
+  {
+    neon_counter_rng_detail::generate(*this, counter_start, dst, n);
+  }
+
+  void generate_uniform(uint64_t counter_start, double* dst, size_t n) const
+  {
+    neon_counter_rng_detail::generate_uniform(*this, counter_start, dst, n,
+                                              neon_counter_rng_detail::to_unit_double);
+  }
+
+  // Four blocks: two pairs of lanes kept in flight to hide the round latency.
+  void generate_step(uint64_t counter, uint64_t* dst) const
+  {
+    uint64x2_t inj[6][2];
+    load_injections(inj);
+    const uint64_t c[4] = { counter, counter + 1, counter + 2, counter + 3 };
+    auto a0 = vaddq_u64(vld1q_u64(c), inj[0][0]);
+    auto a1 = inj[0][1];
+    auto b0 = vaddq_u64(vld1q_u64(c + 2), inj[0][0]);
+    auto b1 = inj[0][1];
+    rounds(&a0, &a1, inj);
+    rounds(&b0, &b1, inj);
+    vst1q_u64(dst + 0, vcombine_u64(vget_low_u64(a0), vget_low_u64(a1)));
+    vst1q_u64(dst + 2, vcombine_u64(vget_high_u64(a0), vget_high_u64(a1)));
+    vst1q_u64(dst + 4, vcombine_u64(vget_low_u64(b0), vget_low_u64(b1)));
+    vst1q_u64(dst + 6, vcombine_u64(vget_high_u64(b0), vget_high_u64(b1)));
+  }
+
+private:
+  void load_injections(uint64x2_t (*inj)[2]) const
+  {
+    for (int s = 0; s < 6; ++s) {
+      inj[s][0] = vdupq_n_u64(inj_[s][0]);
+      inj[s][1] = vdupq_n_u64(inj_[s][1]);
+    }
+  }
+
+  static void rounds(uint64x2_t* x0, uint64x2_t* x1, const uint64x2_t (*inj)[2])
+  {
+    neon_counter_rng_detail::threefry2x64_group<0>(x0, x1, inj);
+    neon_counter_rng_detail::threefry2x64_group<1>(x0, x1, inj);
+    neon_counter_rng_detail::threefry2x64_group<2>(x0, x1, inj);
+    neon_counter_rng_detail::threefry2x64_group<3>(x0, x1, inj);
+    neon_counter_rng_detail::threefry2x64_group<4>(x0, x1, inj);
+  }
+
+  uint64_t inj_[6][2];
+};
+
+class neon_threefry4x32 {
+public:
+  typedef uint32_t value_type;
+  static const int kWords = 4;
+  static const int kStep = 16;
+
+  explicit neon_threefry4x32(const uint32_t* key)
+  {
+    const uint32_t ks[5] = { key[0], key[1], key[2], key[3],
+                             0x1BD11BDA ^ key[0] ^ key[1] ^ key[2] ^ key[3] };
+    for (int s = 0; s < 6; ++s) {
+      for (int w = 0; w < 4; ++w) {
+        inj_[s][w] = ks[(s + w) % 5];
+      }
+      inj_[s][3] += s;
+    }
+  }
+
+  void block(const uint32_t* ctr, uint32_t* out) const
+  {
+    uint32x4_t inj[6][4];
+    load_injections(inj);
+    uint32x4_t x[4];
+    for (int w = 0; w < 4; ++w) {
+      x[w] = vaddq_u32(vdupq_n_u32(ctr[w]), inj[0][w]);
+    }
+    rounds(x, inj);
+    for (int w = 0; w < 4; ++w) {
+      out[w] = vgetq_lane_u32(x[w], 0);
+    }
+  }
+
+  void generate(uint64_t counter_start, uint32_t* dst, size_t n) const
+  {
+    neon_counter_rng_detail::generate(*this, counter_start, dst, n);
+  }
+
+  void generate_uniform(uint64_t counter_start, float* dst, size_t n) const
+  {
+    neon_counter_rng_detail::generate_uniform(*this, counter_start, dst, n,
+                                              neon_counter_rng_detail::to_unit_float);
+  }
+
+  // Four blocks, one per lane; the 64-bit counter spans words 0 and 1.
+  void generate_step(uint64_t counter, uint32_t* dst) const
+  {
+    uint32x4_t inj[6][4];
+    load_injections(inj);
+    uint32_t lo[4], hi[4];
+    for (int j = 0; j < 4; ++j) {
+      lo[j] = static_cast<uint32_t>(counter + j);
+      hi[j] = static_cast<uint32_t>((counter + j) >> 32);
+    }
+    uint32x4x4_t x;
+    x.val[0] = vaddq_u32(vld1q_u32(lo), inj[0][0]);
+    x.val[1] = vaddq_u32(vld1q_u32(hi), inj[0][1]);
+    x.val[2] = inj[0][2];
+    x.val[3] = inj[0][3];
+    rounds(x.val, inj);
+    vst4q_u32(dst, x);
+  }
+
+private:
+  void load_injections(uint32x4_t (*inj)[4]) const
+  {
+    for (int s = 0; s < 6; ++s) {
+      for (int w = 0; w < 4; ++w) {
+        inj[s][w] = vdupq_n_u32(inj_[s][w]);
+      }
+    }
+  }
+
+  static void rounds(uint32x4_t* x, const uint32x4_t (*inj)[4])
+  {
+    neon_counter_rng_detail::threefry4x32_group<0>(x, inj);
+    neon_counter_rng_detail::threefry4x32_group<1>(x, inj);
+    neon_counter_rng_detail::threefry4x32_group<2>(x, inj);
+    neon_counter_rng_detail::threefry4x32_group<3>(x, inj);
+    neon_counter_rng_detail::threefry4x32_group<4>(x, inj);
+  }
+
+  uint32_t inj_[6][4];
+};
+
+// Philox-4x32-10, for comparison: multiplications instead of rotations.
+class neon_philox4x32 {
+public:
+  typedef uint32_t value_type;
+  static const int kWords = 4;
+  static const int kStep = 16;
+
+  explicit neon_philox4x32(const uint32_t* key)
+  {
+    for (int r = 0; r < 10; ++r) {
+      key_[r][0] = key[0] + r * 0x9E3779B9U;
+      key_[r][1] = key[1] + r * 0xBB67AE85U;
+    }
+  }
+
+  void block(const uint32_t* ctr, uint32_t* out) const
+  {
+    uint32x4_t x[4];
+    for (int w = 0; w < 4; ++w) {
+      x[w] = vdupq_n_u32(ctr[w]);
+    }
+    rounds(x);
+    for (int w = 0; w < 4; ++w) {
+      out[w] = vgetq_lane_u32(x[w], 0);
+    }
+  }
+
+  void generate(uint64_t counter_start, uint32_t* dst, size_t n) const
+  {
+    neon_counter_rng_detail::generate(*this, counter_start, dst, n);
+  }
+
+  void generate_uniform(uint64_t counter_start, float* dst, size_t n) const
+  {
+    neon_counter_rng_detail::generate_uniform(*this, counter_start, dst, n,
+                                              neon_counter_rng_detail::to_unit_float);
+  }
+
+  void generate_step(uint64_t counter, uint32_t* dst) const
+  {
+    uint32_t lo[4], hi[4];
+    for (int j = 0; j < 4; ++j) {
+      lo[j] = static_cast<uint32_t>(counter + j);
+      hi[j] = static_cast<uint32_t>((counter + j) >> 32);
+    }
+    uint32x4x4_t x;
+    x.val[0] = vld1q_u32(lo);
+    x.val[1] = vld1q_u32(hi);
+    x.val[2] = vdupq_n_u32(0);
+    x.val[3] = vdupq_n_u32(0);
+    rounds(x.val);
+    vst4q_u32(dst, x);
+  }
+
+private:
+  void rounds(uint32x4_t* x) const
+  {
+    const auto m0 = vdup_n_u32(0xD2511F53);
+    const auto m1 = vdup_n_u32(0xCD9E8D57);
+    for (int r = 0; r < 10; ++r) {
+      uint32x4_t hi0, lo0, hi1, lo1;
+      neon_counter_rng_detail::mulhilo(x[0], m0, &hi0, &lo0);
+      neon_counter_rng_detail::mulhilo(x[2], m1, &hi1, &lo1);
+      x[0] = veorq_u32(veorq_u32(hi1, x[1]), vdupq_n_u32(key_[r][0]));
+      x[1] = lo1;
+      x[2] = veorq_u32(veorq_u32(hi0, x[3]), vdupq_n_u32(key_[r][1]));
+      x[3] = lo0;
+    }
+  }
+
+  uint32_t key_[10][2];
+};
+
+// Splits [counter_start, counter_start + blocks) across threads. Each thread
+// owns a contiguous range of blocks, so the output is identical to generate().
+// threads below 1 count as 1.
+template<typename Gen>
+void neon_counter_rng_generate_parallel(const Gen& gen, uint64_t counter_start,
+                                        typename Gen::value_type* dst, size_t n, int threads)
+{
+  threads = std::max(threads, 1);
+  const size_t blocks = (n + Gen::kWords - 1) / Gen::kWords;
+  const size_t per_thread = (blocks + threads - 1) / threads;
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; ++t) {
+    const size_t b = t * per_thread;
+    if (b >= blocks) {
+      break;
+    }
+    const size_t begin = b * Gen::kWords;
+    const size_t end = std::min(n, (b + per_thread) * Gen::kWords);
+    pool.emplace_back([&gen, counter_start, dst, b, begin, end]() {
+      gen.generate(counter_start + b, dst + begin, end - begin);
+    });
+  }
+  for (auto& th : pool) {
+    th.join();
+  }
+}
+
+#endif /* NEON_COUNTER_RNG_H */
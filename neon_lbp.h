@@ -0,0 +1,167 @@
+#ifndef NEON_LBP_H
+#define NEON_LBP_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <arm_neon.h>
+
+#include "neon_circular_shift.h"
+
+// Local binary patterns of 8-bit grayscale images with the 8 neighbours at
+// radius 1. Bit p of the code is set when neighbour p >= the centre pixel,
+// with the neighbours taken counter-clockwise starting from the right:
+//   3 2 1
+//   4 c 0
+//   5 6 7
+// so rotating the code rotates the neighbourhood by 45 degrees.
+//   none: the raw code.
+//   ri:   the minimum of the code over its 8 circular rotations (36 values).
+//   riu2: the number of set bits for uniform codes (at most two 0/1
+//         transitions around the circle), 9 otherwise (10 values).
+// Each output row only reads the three source rows around it, so an image of
+// any height is processed without intermediate buffers.
+
+enum class neon_lbp_mapping { none, ri, riu2 };
+
+namespace neon_lbp_detail {
+
+static inline uint8_t rotl8(uint8_t v, int n)
+{
+  return static_cast<uint8_t>((v << n) | (v >> (8 - n)));
+}
+
+static inline int popcount8(uint8_t v)
+{
+  int n = 0;
+  for (; v; v &= v - 1) {
+    ++n;
+  }
+  return n;
+}
+
+static inline uint8_t map_code(uint8_t code, neon_lbp_mapping mapping)
+{
+  if (mapping == neon_lbp_mapping::ri) {
+    auto m = code;
+    for (int r = 1; r < 8; ++r) {
+      const auto c = rotl8(code, r);
+      m = c < m ? c : m;
+    }
+    return m;
+  }
+  if (mapping == neon_lbp_mapping::riu2) {
+    return popcount8(code ^ rotl8(code, 1)) <= 2 ? static_cast<uint8_t>(popcount8(code)) : 9;
+  }
+  return code;
+}
+
+static inline uint8_t code_at(const uint8_t* above, const uint8_t* center, const uint8_t* below, size_t x)
+{
+  const uint8_t n[8] = {
+    center[x + 1], above[x + 1], above[x], above[x - 1],
+    center[x - 1], below[x - 1], below[x], below[x + 1]
+  };
+  uint8_t code = 0;
+  for (int p = 0; p < 8; ++p) {
+    code |= static_cast<uint8_t>((n[p] >= center[x]) << p);
+  }
+  return code;
+}
+
+static inline uint8x16_t bit(uint8x16_t code, uint8x16_t neighbour, uint8x16_t c, int p)
+{
+  return vorrq_u8(code, vandq_u8(vcgeq_u8(neighbour, c), vdupq_n_u8(static_cast<uint8_t>(1 << p))));
+}
+
+// Codes of the 16 pixels centre[x .. x + 15].
+static inline uint8x16_t code16(const uint8_t* above, const uint8_t* center, const uint8_t* below, size_t x)
+{
+  const auto c = vld1q_u8(center + x);
+  auto code = vandq_u8(vcgeq_u8(vld1q_u8(center + x + 1), c), vdupq_n_u8(1));
+  code = bit(code, vld1q_u8(above + x + 1), c, 1);
+  code = bit(code, vld1q_u8(above + x), c, 2);
+  code = bit(code, vld1q_u8(above + x - 1), c, 3);
+  code = bit(code, vld1q_u8(center + x - 1), c, 4);
+  code = bit(code, vld1q_u8(below + x - 1), c, 5);
+  code = bit(code, vld1q_u8(below + x), c, 6);
+  code = bit(code, vld1q_u8(below + x + 1), c, 7);
+  return code;
+}
+
+static inline uint8x16_t map16(uint8x16_t code, neon_lbp_mapping mapping)
+{
+  if (mapping == neon_lbp_mapping::ri) {
+    auto m = vminq_u8(code, vshlcq_n_u8<1>(code));
+    m = vminq_u8(m, vshlcq_n_u8<2>(code));
+    m = vminq_u8(m, vshlcq_n_u8<3>(code));
+    m = vminq_u8(m, vshlcq_n_u8<4>(code));
+    m = vminq_u8(m, vshlcq_n_u8<5>(code));
+    m = vminq_u8(m, vshlcq_n_u8<6>(code));
+    return vminq_u8(m, vshlcq_n_u8<7>(code));
+  }
+  if (mapping == neon_lbp_mapping::riu2) {
+    const auto transitions = vcntq_u8(veorq_u8(code, vshlcq_n_u8<1>(code)));
+    return vbslq_u8(vcleq_u8(transitions, vdupq_n_u8(2)), vcntq_u8(code), vdupq_n_u8(9));
+  }
+  return code;
+}
+
+template<neon_lbp_mapping mapping>
+static inline void row(const uint8_t* above, const uint8_t* center, const uint8_t* below,
+                       uint8_t* dst, size_t width)
+{
+  const auto n = width - 2;
+  if (n < 16) {
+    for (size_t x = 1; x <= n; ++x) {
+      dst[x - 1] = map_code(code_at(above, center, below, x), mapping);
+    }
+    return;
+  }
+  // Pixels 1 .. n; the last vector overlaps the previous one.
+  for (size_t x = 1;; x += 16) {
+    if (x + 16 > n + 1) {
+      x = n + 1 - 16;
+    }
+    vst1q_u8(dst + x - 1, map16(code16(above, center, below, x), mapping));
+    if (x + 16 == n + 1) {
+      break;
+    }
+  }
+}
+
+} // namespace neon_lbp_detail
+
+// Writes the width - 2 codes of the interior pixels of `center`, whose
+// neighbouring rows are `above` and `below`.
+static inline void neon_lbp_row(const uint8_t* above, const uint8_t* center, const uint8_t* below,
+                                uint8_t* dst, size_t width, neon_lbp_mapping mapping)
+{
+  if (width < 3) {
+    return;
+  }
+  switch (mapping) {
+  case neon_lbp_mapping::none:
+    neon_lbp_detail::row<neon_lbp_mapping::none>(above, center, below, dst, width);
+    break;
+  case neon_lbp_mapping::ri:
+    neon_lbp_detail::row<neon_lbp_mapping::ri>(above, center, below, dst, width);
+    break;
+  case neon_lbp_mapping::riu2:
+    neon_lbp_detail::row<neon_lbp_mapping::riu2>(above, center, below, dst, width);
+    break;
+  }
+}
+
+// Row y of `dst` (height - 2 rows of width - 2 codes) is the LBP of source
+// row y + 1; the one-pixel border has no code.
+static inline void neon_lbp(const uint8_t* src, size_t width, size_t height, size_t src_stride,
+                            uint8_t* dst, size_t dst_stride, neon_lbp_mapping mapping)
+{
+  for (size_t y = 1; y + 1 < height; ++y) {
+    neon_lbp_row(src + (y - 1) * src_stride, src + y * src_stride, src + (y + 1) * src_stride,
+                 dst + (y - 1) * dst_stride, width, mapping);
+  }
+}
+
+#endif /* NEON_LBP_H */
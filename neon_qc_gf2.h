@@ -0,0 +1,175 @@
+#ifndef NEON_QC_GF2_H
+#define NEON_QC_GF2_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <arm_neon.h>
+
+#include <vector>
+
+// Block matrix of p x p circulants over GF(2) times a bit vector, as used by
+// QC-LDPC and QC-MDPC (BIKE) encoders and decoders. A circulant is given by
+// the positions t of the ones in its first column, and multiplies a block x by
+//   y = XOR over t of rot(x, t),   rot(x, t)[i] = x[(i - t) mod p]
+// Bit i of a block is bit i % 32 of word i / 32; a block takes (p + 31) / 32
+// words and the bits past p are zero.
+//
+// rot(x, t) is never materialised. x is extended periodically, and the words
+// of rot(x, t) are read from it at bit offset p - t:
+//   sparse blocks funnel-shift two overlapping vector loads on the fly;
+//   dense blocks read from 32 bit-shifted copies of the extension, built once
+//   per column and shared by every dense block in that column.
+
+namespace neon_qc_gf2_detail {
+
+// Words [begin, begin + 4n) of the extension shifted right by b, XORed into acc.
+static inline void xor_funnel(uint32_t* acc, const uint32_t* ext, size_t n, int b)
+{
+  if (b == 0) {
+    for (size_t j = 0; j < n; ++j) {
+      vst1q_u32(acc + 4 * j, veorq_u32(vld1q_u32(acc + 4 * j), vld1q_u32(ext + 4 * j)));
+    }
+    return;
+  }
+  const auto right = vdupq_n_s32(-b);
+  const auto left = vdupq_n_s32(32 - b);
+  for (size_t j = 0; j < n; ++j) {
+    const auto lo = vshlq_u32(vld1q_u32(ext + 4 * j), right);
+    const auto hi = vshlq_u32(vld1q_u32(ext + 4 * j + 1), left);
+    vst1q_u32(acc + 4 * j, veorq_u32(vld1q_u32(acc + 4 * j), vorrq_u32(lo, hi)));
+  }
+}
+
+static inline void xor_words(uint32_t* acc, const uint32_t* src, size_t n)
+{
+  for (size_t j = 0; j < n; ++j) {
+    vst1q_u32(acc + 4 * j, veorq_u32(vld1q_u32(acc + 4 * j), vld1q_u32(src + 4 * j)));
+  }
+}
+
+} // namespace neon_qc_gf2_detail
+
+class neon_qc_gf2_matrix {
+public:
+  // A rows x cols block matrix of zero p x p circulants.
+  neon_qc_gf2_matrix(size_t rows, size_t cols, size_t p)
+    : rows_(rows), cols_(cols), p_(p), words_((p + 31) / 32), vectors_((words_ + 3) / 4),
+      blocks_(rows * cols)
+  {
+    // Bit offsets are below p, and a read covers 4 * vectors_ + 1 words.
+    ext_words_ = (p + 31) / 32 + 4 * vectors_ + 2;
+  }
+
+  size_t block_words() const
+  {
+    return words_;
+  }
+
+  // Circulant with ones at the given positions of its first column.
+  void set_sparse(size_t r, size_t c, const uint32_t* positions, size_t weight)
+  {
+    auto& block = blocks_[r * cols_ + c];
+    block.dense = false;
+    block.offsets.clear();
+    for (size_t i = 0; i < weight; ++i) {
+      block.offsets.push_back(static_cast<uint32_t>((p_ - positions[i] % p_) % p_));
+    }
+  }
+
+  // Circulant whose first column is the p-bit vector `column`.
+  void set_dense(size_t r, size_t c, const uint32_t* column)
+  {
+    auto& block = blocks_[r * cols_ + c];
+    block.dense = true;
+    block.offsets.clear();
+    for (size_t t = 0; t < p_; ++t) {
+      if ((column[t / 32] >> (t % 32)) & 1) {
+        block.offsets.push_back(static_cast<uint32_t>((p_ - t) % p_));
+      }
+    }
+  }
+
+  // y (rows blocks) = M x (cols blocks).
+  void multiply(const uint32_t* x, uint32_t* y) const
+  {
+    const auto acc_words = 4 * vectors_;
+    std::vector<uint32_t> acc(rows_ * acc_words, 0);
+    std::vector<uint32_t> ext(ext_words_);
+    std::vector<uint32_t> shifted;
+    for (size_t c = 0; c < cols_; ++c) {
+      extend(x + c * words_, ext.data());
+      bool any_dense = false;
+      for (size_t r = 0; r < rows_; ++r) {
+        any_dense |= blocks_[r * cols_ + c].dense;
+      }
+      if (any_dense) {
+        build_shifted(ext.data(), &shifted);
+      }
+      for (size_t r = 0; r < rows_; ++r) {
+        const auto& block = blocks_[r * cols_ + c];
+        auto* a = acc.data() + r * acc_words;
+        for (const auto o : block.offsets) {
+          if (block.dense) {
+            neon_qc_gf2_detail::xor_words(a, shifted.data() + (o % 32) * ext_words_ + o / 32, vectors_);
+          } else {
+            neon_qc_gf2_detail::xor_funnel(a, ext.data() + o / 32, vectors_, static_cast<int>(o % 32));
+          }
+        }
+      }
+    }
+    const uint32_t tail_mask = p_ % 32 ? (1U << (p_ % 32)) - 1 : ~0U;
+    for (size_t r = 0; r < rows_; ++r) {
+      memcpy(y + r * words_, acc.data() + r * acc_words, words_ * sizeof(uint32_t));
+      y[r * words_ + words_ - 1] &= tail_mask;
+    }
+  }
+
+private:
+  struct block {
+    bool dense = false;
+    // p - t for each position t, the bit offset of rot(x, t) in the extension.
+    std::vector<uint32_t> offsets;
+  };
+
+  // ext bit k = x bit (k mod p), over ext_words_ words.
+  void extend(const uint32_t* x, uint32_t* ext) const
+  {
+    const uint32_t tail_mask = p_ % 32 ? (1U << (p_ % 32)) - 1 : ~0U;
+    memset(ext, 0, ext_words_ * sizeof(uint32_t));
+    for (size_t start = 0; start < 32 * ext_words_; start += p_) {
+      const auto q = start / 32;
+      const auto s = start % 32;
+      for (size_t j = 0; j < words_ && q + j < ext_words_; ++j) {
+        const auto w = j + 1 == words_ ? x[j] & tail_mask : x[j];
+        ext[q + j] |= w << s;
+        if (s && q + j + 1 < ext_words_) {
+          ext[q + j + 1] |= w >> (32 - s);
+        }
+      }
+    }
+  }
+
+  // shifted[b * ext_words_ + k] = ext words k, k + 1 shifted right by b.
+  void build_shifted(const uint32_t* ext, std::vector<uint32_t>* shifted) const
+  {
+    shifted->assign(32 * ext_words_, 0);
+    for (int b = 0; b < 32; ++b) {
+      auto* s = shifted->data() + b * ext_words_;
+      for (size_t k = 0; k + 1 < ext_words_; ++k) {
+        s[k] = b ? (ext[k] >> b) | (ext[k + 1] << (32 - b)) : ext[k];
+      }
+    }
+  }
+
+  size_t rows_;
+  size_t cols_;
+  size_t p_;
+  size_t words_;
+  size_t vectors_;
+  size_t ext_words_;
+  std::vector<block> blocks_;
+};
+
+#endif /* NEON_QC_GF2_H */
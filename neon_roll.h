@@ -0,0 +1,207 @@
+#ifndef NEON_ROLL_H
+#define NEON_ROLL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <arm_neon.h>
+
+#include <algorithm>
+#include <vector>
+
+// Circular shift of whole arrays, like numpy.roll: element i moves to
+// (i + shift) mod n, and in 2D element (x, y) moves to
+// ((x + dx) mod width, (y + dy) mod height). Shifts may be negative or larger
+// than the array. T is uint8_t, uint16_t, uint32_t or uint64_t, and strides
+// count elements.
+//
+// Out-of-place rolls are two NEON copies per row. The in-place 1D roll moves
+// a short part (up to 4 KB) through a buffer, and otherwise reverses both
+// parts and then the whole array. The in-place 2D roll moves
+// rows along the cycles of the vertical shift, rolling each row by dx as it
+// is copied into place, so every element is read and written once, plus one
+// temporary row per cycle that stays in cache.
+
+namespace neon_roll_detail {
+
+static const size_t kShortBytes = 4096;
+
+static inline void copy(void* dst, const void* src, size_t bytes)
+{
+  auto d = static_cast<uint8_t*>(dst);
+  auto s = static_cast<const uint8_t*>(src);
+  size_t i = 0;
+  for (; i + 64 <= bytes; i += 64) {
+    const auto a = vld1q_u8(s + i);
+    const auto b = vld1q_u8(s + i + 16);
+    const auto c = vld1q_u8(s + i + 32);
+    const auto e = vld1q_u8(s + i + 48);
+    vst1q_u8(d + i, a);
+    vst1q_u8(d + i + 16, b);
+    vst1q_u8(d + i + 32, c);
+    vst1q_u8(d + i + 48, e);
+  }
+  for (; i + 16 <= bytes; i += 16) {
+    vst1q_u8(d + i, vld1q_u8(s + i));
+  }
+  memcpy(d + i, s + i, bytes - i);
+}
+
+template<size_t size>
+uint8x16_t reverse_lanes(uint8x16_t v);
+
+template<>
+inline uint8x16_t reverse_lanes<1>(uint8x16_t v)
+{
+  const auto r = vrev64q_u8(v);
+  return vcombine_u8(vget_high_u8(r), vget_low_u8(r));
+}
+
+template<>
+inline uint8x16_t reverse_lanes<2>(uint8x16_t v)
+{
+  const auto r = vreinterpretq_u8_u16(vrev64q_u16(vreinterpretq_u16_u8(v)));
+  return vcombine_u8(vget_high_u8(r), vget_low_u8(r));
+}
+
+template<>
+inline uint8x16_t reverse_lanes<4>(uint8x16_t v)
+{
+  const auto r = vreinterpretq_u8_u32(vrev64q_u32(vreinterpretq_u32_u8(v)));
+  return vcombine_u8(vget_high_u8(r), vget_low_u8(r));
+}
+
+template<>
+inline uint8x16_t reverse_lanes<8>(uint8x16_t v)
+{
+  return vcombine_u8(vget_high_u8(v), vget_low_u8(v));
+}
+
+template<typename T>
+void reverse(T* a, size_t n)
+{
+  static const size_t kLanes = 16 / sizeof(T);
+  size_t i = 0;
+  size_t j = n;
+  for (; j - i >= 2 * kLanes; i += kLanes, j -= kLanes) {
+    auto lo = reinterpret_cast<uint8_t*>(a + i);
+    auto hi = reinterpret_cast<uint8_t*>(a + j - kLanes);
+    const auto x = vld1q_u8(lo);
+    const auto y = vld1q_u8(hi);
+    vst1q_u8(lo, reverse_lanes<sizeof(T)>(y));
+    vst1q_u8(hi, reverse_lanes<sizeof(T)>(x));
+  }
+  std::reverse(a + i, a + j);
+}
+
+static inline size_t gcd(size_t a, size_t b)
+{
+  while (b) {
+    const auto t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+static inline size_t wrap(ptrdiff_t shift, size_t n)
+{
+  const auto m = static_cast<ptrdiff_t>(n);
+  return static_cast<size_t>(((shift % m) + m) % m);
+}
+
+// dst = src rolled by s, 0 <= s < n; src and dst do not overlap.
+template<typename T>
+void roll_row(const T* src, T* dst, size_t n, size_t s)
+{
+  copy(dst + s, src, (n - s) * sizeof(T));
+  copy(dst, src + n - s, s * sizeof(T));
+}
+
+} // namespace neon_roll_detail
+
+template<typename T>
+void neon_roll(const T* src, T* dst, size_t n, ptrdiff_t shift)
+{
+  if (n == 0) {
+    return;
+  }
+  neon_roll_detail::roll_row(src, dst, n, neon_roll_detail::wrap(shift, n));
+}
+
+template<typename T>
+void neon_roll_inplace(T* data, size_t n, ptrdiff_t shift)
+{
+  if (n == 0) {
+    return;
+  }
+  const auto s = neon_roll_detail::wrap(shift, n);
+  if (s == 0) {
+    return;
+  }
+  // A short part goes through a stack buffer while the long one moves over.
+  static const size_t kShort = neon_roll_detail::kShortBytes / sizeof(T);
+  T tmp[kShort];
+  if (s <= kShort) {
+    neon_roll_detail::copy(tmp, data + n - s, s * sizeof(T));
+    memmove(data + s, data, (n - s) * sizeof(T));
+    neon_roll_detail::copy(data, tmp, s * sizeof(T));
+    return;
+  }
+  if (n - s <= kShort) {
+    neon_roll_detail::copy(tmp, data, (n - s) * sizeof(T));
+    memmove(data, data + n - s, s * sizeof(T));
+    neon_roll_detail::copy(data + s, tmp, (n - s) * sizeof(T));
+    return;
+  }
+  neon_roll_detail::reverse(data, n - s);
+  neon_roll_detail::reverse(data + n - s, s);
+  neon_roll_detail::reverse(data, n);
+}
+
+template<typename T>
+void neon_roll_2d(const T* src, size_t src_stride, T* dst, size_t dst_stride,
+                  size_t width, size_t height, ptrdiff_t dx, ptrdiff_t dy)
+{
+  if (width == 0 || height == 0) {
+    return;
+  }
+  const auto sx = neon_roll_detail::wrap(dx, width);
+  const auto sy = neon_roll_detail::wrap(dy, height);
+  for (size_t y = 0; y < height; ++y) {
+    const auto from = (y + height - sy) % height;
+    neon_roll_detail::roll_row(src + from * src_stride, dst + y * dst_stride, width, sx);
+  }
+}
+
+template<typename T>
+void neon_roll_2d_inplace(T* data, size_t stride, size_t width, size_t height, ptrdiff_t dx, ptrdiff_t dy)
+{
+  if (width == 0 || height == 0) {
+    return;
+  }
+  const auto sx = neon_roll_detail::wrap(dx, width);
+  const auto sy = neon_roll_detail::wrap(dy, height);
+  if (sx == 0 && sy == 0) {
+    return;
+  }
+  std::vector<T> tmp(width);
+  // Row y receives row y - sy; the rows form gcd(height, sy) cycles.
+  const auto cycles = neon_roll_detail::gcd(height, sy);
+  for (size_t c = 0; c < cycles; ++c) {
+    neon_roll_detail::copy(tmp.data(), data + c * stride, width * sizeof(T));
+    auto cur = c;
+    for (;;) {
+      const auto from = (cur + height - sy) % height;
+      if (from == c) {
+        neon_roll_detail::roll_row(tmp.data(), data + cur * stride, width, sx);
+        break;
+      }
+      neon_roll_detail::roll_row(data + from * stride, data + cur * stride, width, sx);
+      cur = from;
+    }
+  }
+}
+
+#endif /* NEON_ROLL_H */
@@ -0,0 +1,231 @@
+#ifndef NEON_SPECK_H
+#define NEON_SPECK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <arm_neon.h>
+
+#include "neon_circular_shift.h"
+
+// Speck64/128 and Speck128/128 in CTR mode, one block per lane.
+// Bytes map to words little-endian as in the Speck implementation guide:
+// a block is y followed by x, and a key is k0 followed by l0, l1, ...
+// The CTR counter block is the IV read as a little-endian integer plus the
+// block index, so ctr() on a buffer offset by b blocks only needs iv + b.
+// The round rotations are ror 8 (TBL on AArch64, VSHR + VSLI on ARMv7) and
+// rol 3 (VSLI).
+
+namespace neon_speck_detail {
+
+static inline uint32_t ror32(uint32_t v, int n)
+{
+  return (v >> n) | (v << (32 - n));
+}
+
+static inline uint64_t ror64(uint64_t v, int n)
+{
+  return (v >> n) | (v << (64 - n));
+}
+
+static inline uint64_t load_le64(const uint8_t* p)
+{
+  uint64_t v = 0;
+  for (int i = 7; i >= 0; --i) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+
+static inline void round_u32(uint32x4_t* x, uint32x4_t* y, uint32x4_t k)
+{
+  *x = veorq_u32(vaddq_u32(vshlcq_n_u32<24>(*x), *y), k);
+  *y = veorq_u32(vshlcq_n_u32<3>(*y), *x);
+}
+
+static inline void round_u64(uint64x2_t* x, uint64x2_t* y, uint64x2_t k)
+{
+  *x = veorq_u64(vaddq_u64(vshlcq_n_u64<56>(*x), *y), k);
+  *y = veorq_u64(vshlcq_n_u64<3>(*y), *x);
+}
+
+static inline void xor_tail(const uint8_t* src, uint8_t* dst, const uint8_t* ks, size_t bytes)
+{
+  for (size_t i = 0; i < bytes; ++i) {
+    dst[i] = src[i] ^ ks[i];
+  }
+}
+
+} // namespace neon_speck_detail
+
+class neon_speck64_128 {
+public:
+  static const int kBlockBytes = 8;
+  static const int kRounds = 27;
+
+  explicit neon_speck64_128(const uint8_t* key)
+  {
+    uint32_t w[4];
+    memcpy(w, key, sizeof(w));
+    uint32_t k = w[0];
+    uint32_t l[kRounds + 2] = { w[1], w[2], w[3] };
+    for (int i = 0; i < kRounds; ++i) {
+      rk_[i] = k;
+      if (i + 1 < kRounds) {
+        l[i + 3] = (k + neon_speck_detail::ror32(l[i], 8)) ^ static_cast<uint32_t>(i);
+        k = neon_speck_detail::ror32(k, 29) ^ l[i + 3];
+      }
+    }
+  }
+
+  void encrypt_block(const uint8_t* in, uint8_t* out) const
+  {
+    uint32_t w[2];
+    memcpy(w, in, sizeof(w));
+    auto y = vdupq_n_u32(w[0]);
+    auto x = vdupq_n_u32(w[1]);
+    for (int r = 0; r < kRounds; ++r) {
+      neon_speck_detail::round_u32(&x, &y, vdupq_n_u32(rk_[r]));
+    }
+    w[0] = vgetq_lane_u32(y, 0);
+    w[1] = vgetq_lane_u32(x, 0);
+    memcpy(out, w, sizeof(w));
+  }
+
+  // Encrypts or decrypts `bytes` bytes with the keystream for the 8-byte IV.
+  void ctr(const uint8_t* iv, const uint8_t* src, uint8_t* dst, size_t bytes) const
+  {
+    static const size_t kStepBytes = 8 * kBlockBytes;
+    auto counter = neon_speck_detail::load_le64(iv);
+    size_t i = 0;
+    for (; i + kStepBytes <= bytes; i += kStepBytes, counter += 8) {
+      uint32x4x2_t ks[2];
+      keystream(counter, ks);
+      for (int h = 0; h < 2; ++h) {
+        auto v = vld2q_u32(reinterpret_cast<const uint32_t*>(src + i + 32 * h));
+        v.val[0] = veorq_u32(v.val[0], ks[h].val[0]);
+        v.val[1] = veorq_u32(v.val[1], ks[h].val[1]);
+        vst2q_u32(reinterpret_cast<uint32_t*>(dst + i + 32 * h), v);
+      }
+    }
+    if (i < bytes) {
+      uint32x4x2_t ks[2];
+      keystream(counter, ks);
+      uint32_t tmp[16];
+      vst2q_u32(tmp, ks[0]);
+      vst2q_u32(tmp + 8, ks[1]);
+      neon_speck_detail::xor_tail(src + i, dst + i, reinterpret_cast<const uint8_t*>(tmp), bytes - i);
+    }
+  }
+
+private:
+  // Eight blocks as two independent sets of four lanes; val[0] is y, val[1] is x.
+  void keystream(uint64_t counter, uint32x4x2_t* ks) const
+  {
+    uint32_t lo[8], hi[8];
+    for (int j = 0; j < 8; ++j) {
+      lo[j] = static_cast<uint32_t>(counter + j);
+      hi[j] = static_cast<uint32_t>((counter + j) >> 32);
+    }
+    auto y0 = vld1q_u32(lo);
+    auto x0 = vld1q_u32(hi);
+    auto y1 = vld1q_u32(lo + 4);
+    auto x1 = vld1q_u32(hi + 4);
+    for (int r = 0; r < kRounds; ++r) {
+      const auto k = vdupq_n_u32(rk_[r]);
+      neon_speck_detail::round_u32(&x0, &y0, k);
+      neon_speck_detail::round_u32(&x1, &y1, k);
+    }
+    ks[0].val[0] = y0;
+    ks[0].val[1] = x0;
+    ks[1].val[0] = y1;
+    ks[1].val[1] = x1;
+  }
+
+  uint32_t rk_[kRounds];
+};
+
+class neon_speck128_128 {
+public:
+  static const int kBlockBytes = 16;
+  static const int kRounds = 32;
+
+  explicit neon_speck128_128(const uint8_t* key)
+  {
+    uint64_t k = neon_speck_detail::load_le64(key);
+    uint64_t l = neon_speck_detail::load_le64(key + 8);
+    for (int i = 0; i < kRounds; ++i) {
+      rk_[i] = k;
+      l = (k + neon_speck_detail::ror64(l, 8)) ^ static_cast<uint64_t>(i);
+      k = neon_speck_detail::ror64(k, 61) ^ l;
+    }
+  }
+
+  void encrypt_block(const uint8_t* in, uint8_t* out) const
+  {
+    auto y = vdupq_n_u64(neon_speck_detail::load_le64(in));
+    auto x = vdupq_n_u64(neon_speck_detail::load_le64(in + 8));
+    for (int r = 0; r < kRounds; ++r) {
+      neon_speck_detail::round_u64(&x, &y, vdupq_n_u64(rk_[r]));
+    }
+    const uint64_t w[2] = { vgetq_lane_u64(y, 0), vgetq_lane_u64(x, 0) };
+    memcpy(out, w, sizeof(w));
+  }
+
+  // Encrypts or decrypts `bytes` bytes with the keystream for the 16-byte IV.
+  void ctr(const uint8_t* iv, const uint8_t* src, uint8_t* dst, size_t bytes) const
+  {
+    static const size_t kStepBytes = 4 * kBlockBytes;
+    auto lo = neon_speck_detail::load_le64(iv);
+    auto hi = neon_speck_detail::load_le64(iv + 8);
+    size_t i = 0;
+    for (; i + kStepBytes <= bytes; i += kStepBytes) {
+      uint64x2_t ks[4];
+      keystream(lo, hi, ks);
+      for (int b = 0; b < 4; ++b) {
+        const auto v = vld1q_u64(reinterpret_cast<const uint64_t*>(src + i + 16 * b));
+        vst1q_u64(reinterpret_cast<uint64_t*>(dst + i + 16 * b), veorq_u64(v, ks[b]));
+      }
+      hi += (lo + 4 < lo);
+      lo += 4;
+    }
+    if (i < bytes) {
+      uint64x2_t ks[4];
+      keystream(lo, hi, ks);
+      uint64_t tmp[8];
+      for (int b = 0; b < 4; ++b) {
+        vst1q_u64(tmp + 2 * b, ks[b]);
+      }
+      neon_speck_detail::xor_tail(src + i, dst + i, reinterpret_cast<const uint8_t*>(tmp), bytes - i);
+    }
+  }
+
+private:
+  // Four blocks as two independent sets of two lanes, returned in memory order.
+  void keystream(uint64_t lo, uint64_t hi, uint64x2_t* ks) const
+  {
+    uint64_t ylo[4], xhi[4];
+    for (int j = 0; j < 4; ++j) {
+      ylo[j] = lo + j;
+      xhi[j] = hi + (lo + j < lo);
+    }
+    auto y0 = vld1q_u64(ylo);
+    auto x0 = vld1q_u64(xhi);
+    auto y1 = vld1q_u64(ylo + 2);
+    auto x1 = vld1q_u64(xhi + 2);
+    for (int r = 0; r < kRounds; ++r) {
+      const auto k = vdupq_n_u64(rk_[r]);
+      neon_speck_detail::round_u64(&x0, &y0, k);
+      neon_speck_detail::round_u64(&x1, &y1, k);
+    }
+    ks[0] = vcombine_u64(vget_low_u64(y0), vget_low_u64(x0));
+    ks[1] = vcombine_u64(vget_high_u64(y0), vget_high_u64(x0));
+    ks[2] = vcombine_u64(vget_low_u64(y1), vget_low_u64(x1));
+    ks[3] = vcombine_u64(vget_high_u64(y1), vget_high_u64(x1));
+  }
+
+  uint64_t rk_[kRounds];
+};
+
+#endif /* NEON_SPECK_H */
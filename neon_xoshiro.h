@@ -0,0 +1,408 @@
+#ifndef NEON_XOSHIRO_H
+#define NEON_XOSHIRO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <arm_neon.h>
+
+#include "neon_circular_shift.h"
+
+// Multi-stream xoshiro/xoroshiro generators.
+// Every lane of every state register is an independent stream; stream k
+// starts at the seeded state advanced by k jumps, so the streams never overlap.
+// fill() interleaves the streams: buf[kStreams * i + k] is output i of stream k.
+
+namespace neon_xoshiro_detail {
+
+static inline uint64_t splitmix64(uint64_t* x)
+{
+  auto z = (*x += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static inline uint32_t rotl_u32(uint32_t v, int n)
+{
+  return (v << n) | (v >> (32 - n));
+}
+
+static inline uint64_t rotl_u64(uint64_t v, int n)
+{
+  return (v << n) | (v >> (64 - n));
+}
+
+static inline void step_xoshiro128(uint32_t* s)
+{
+  const auto t = s[1] << 9;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl_u32(s[3], 11);
+}
+
+static inline void step_xoshiro256(uint64_t* s)
+{
+  const auto t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl_u64(s[3], 45);
+}
+
+static inline void step_xoroshiro128(uint64_t* s)
+{
+  const auto s0 = s[0];
+  const auto s1 = s[1] ^ s0;
+  s[0] = rotl_u64(s0, 24) ^ s1 ^ (s1 << 16);
+  s[1] = rotl_u64(s1, 37);
+}
+
+template<typename T, int kWords, int kJumpWords>
+static inline void jump(T* s, const T (&poly)[kJumpWords], void (*step)(T*))
+{
+  T acc[kWords] = {};
+  for (int i = 0; i < kJumpWords; ++i) {
+    for (int b = 0; b < static_cast<int>(sizeof(T) * 8); ++b) {
+      if (poly[i] & (static_cast<T>(1) << b)) {
+        for (int w = 0; w < kWords; ++w) {
+          acc[w] ^= s[w];
+        }
+      }
+      step(s);
+    }
+  }
+  for (int w = 0; w < kWords; ++w) {
+    s[w] = acc[w];
+  }
+}
+
+static inline void jump_xoshiro128(uint32_t* s)
+{
+  static const uint32_t kJump[] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+  jump<uint32_t, 4>(s, kJump, step_xoshiro128);
+}
+
+static inline void jump_xoshiro256(uint64_t* s)
+{
+  static const uint64_t kJump[] = {
+    0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+  };
+  jump<uint64_t, 4>(s, kJump, step_xoshiro256);
+}
+
+static inline void jump_xoroshiro128(uint64_t* s)
+{
+  static const uint64_t kJump[] = { 0xdf900294d8f554a5ULL, 0x170865df4b3201fcULL };
+  jump<uint64_t, 2>(s, kJump, step_xoroshiro128);
+}
+
+} // namespace neon_xoshiro_detail
+
+// xoshiro128++: 8 streams of uint32_t, two Q registers per state word.
+class neon_xoshiro128pp {
+public:
+  static const int kStreams = 8;
+
+  explicit neon_xoshiro128pp(uint64_t seed)
+  {
+    uint32_t s[4];
+    for (int w = 0; w < 4; w += 2) {
+      const auto z = neon_xoshiro_detail::splitmix64(&seed);
+      s[w] = static_cast<uint32_t>(z);
+      s[w + 1] = static_cast<uint32_t>(z >> 32);
+    }
+    for (int k = 0; k < kStreams; ++k) {
+      set_stream(k, s);
+      neon_xoshiro_detail::jump_xoshiro128(s);
+    }
+  }
+
+  // Advances every stream by kStreams * 2^64 steps, i.e. past the streams of
+  // this generator, so a jumped copy yields kStreams new independent streams.
+  void jump()
+  {
+    for (int k = 0; k < kStreams; ++k) {
+      uint32_t s[4];
+      get_stream(k, s);
+      for (int j = 0; j < kStreams; ++j) {
+        neon_xoshiro_detail::jump_xoshiro128(s);
+      }
+      set_stream(k, s);
+    }
+  }
+
+  void fill(uint32_t* buf, size_t n)
+  {
+    size_t i = 0;
+    for (; i + kStreams <= n; i += kStreams) {
+      vst1q_u32(buf + i, next(0));
+      vst1q_u32(buf + i + 4, next(1));
+    }
+    if (i < n) {
+      uint32_t tmp[kStreams];
+      vst1q_u32(tmp, next(0));
+      vst1q_u32(tmp + 4, next(1));
+      memcpy(buf + i, tmp, (n - i) * sizeof(uint32_t));
+    }
+  }
+
+  void fill_bytes(void* buf, size_t bytes)
+  {
+    auto d = static_cast<uint8_t*>(buf);
+    size_t i = 0;
+    for (; i + kStreams * 4 <= bytes; i += kStreams * 4) {
+      vst1q_u8(d + i, vreinterpretq_u8_u32(next(0)));
+      vst1q_u8(d + i + 16, vreinterpretq_u8_u32(next(1)));
+    }
+    if (i < bytes) {
+      uint32_t tmp[kStreams];
+      vst1q_u32(tmp, next(0));
+      vst1q_u32(tmp + 4, next(1));
+      memcpy(d + i, tmp, bytes - i);
+    }
+  }
+
+private:
+  uint32x4_t next(int r)
+  {
+    const auto ret = vaddq_u32(vshlcq_n_u32<7>(vaddq_u32(s0_[r], s3_[r])), s0_[r]);
+    const auto t = vshlq_n_u32(s1_[r], 9);
+    s2_[r] = veorq_u32(s2_[r], s0_[r]);
+    s3_[r] = veorq_u32(s3_[r], s1_[r]);
+    s1_[r] = veorq_u32(s1_[r], s2_[r]);
+    s0_[r] = veorq_u32(s0_[r], s3_[r]);
+    s2_[r] = veorq_u32(s2_[r], t);
+    s3_[r] = vshlcq_n_u32<11>(s3_[r]);
+    return ret;
+  }
+
+  void get_stream(int k, uint32_t* s) const
+  {
+    const uint32x4_t* const regs[] = { s0_, s1_, s2_, s3_ };
+    for (int w = 0; w < 4; ++w) {
+      uint32_t lanes[4];
+      vst1q_u32(lanes, regs[w][k / 4]);
+      s[w] = lanes[k % 4];
+    }
+  }
+
+  void set_stream(int k, const uint32_t* s)
+  {
+    uint32x4_t* const regs[] = { s0_, s1_, s2_, s3_ };
+    for (int w = 0; w < 4; ++w) {
+      uint32_t lanes[4];
+      vst1q_u32(lanes, regs[w][k / 4]);
+      lanes[k % 4] = s[w];
+      regs[w][k / 4] = vld1q_u32(lanes);
+    }
+  }
+
+  uint32x4_t s0_[2], s1_[2], s2_[2], s3_[2];
+};
+
+// xoshiro256**: 4 streams of uint64_t, two Q registers per state word.
+class neon_xoshiro256ss {
+public:
+  static const int kStreams = 4;
+
+  explicit neon_xoshiro256ss(uint64_t seed)
+  {
+    uint64_t s[4];
+    for (int w = 0; w < 4; ++w) {
+      s[w] = neon_xoshiro_detail::splitmix64(&seed);
+    }
+    for (int k = 0; k < kStreams; ++k) {
+      set_stream(k, s);
+      neon_xoshiro_detail::jump_xoshiro256(s);
+    }
+  }
+
+  // Advances every stream by kStreams * 2^128 steps.
+  void jump()
+  {
+    for (int k = 0; k < kStreams; ++k) {
+      uint64_t s[4];
+      get_stream(k, s);
+      for (int j = 0; j < kStreams; ++j) {
+        neon_xoshiro_detail::jump_xoshiro256(s);
+      }
+      set_stream(k, s);
+    }
+  }
+
+  void fill(uint64_t* buf, size_t n)
+  {
+    size_t i = 0;
+    for (; i + kStreams <= n; i += kStreams) {
+      vst1q_u64(buf + i, next(0));
+      vst1q_u64(buf + i + 2, next(1));
+    }
+    if (i < n) {
+      uint64_t tmp[kStreams];
+      vst1q_u64(tmp, next(0));
+      vst1q_u64(tmp + 2, next(1));
+      memcpy(buf + i, tmp, (n - i) * sizeof(uint64_t));
+    }
+  }
+
+  void fill_bytes(void* buf, size_t bytes)
+  {
+    auto d = static_cast<uint8_t*>(buf);
+    size_t i = 0;
+    for (; i + kStreams * 8 <= bytes; i += kStreams * 8) {
+      vst1q_u8(d + i, vreinterpretq_u8_u64(next(0)));
+      vst1q_u8(d + i + 16, vreinterpretq_u8_u64(next(1)));
+    }
+    if (i < bytes) {
+      uint64_t tmp[kStreams];
+      vst1q_u64(tmp, next(0));
+      vst1q_u64(tmp + 2, next(1));
+      memcpy(d + i, tmp, bytes - i);
+    }
+  }
+
+private:
+  uint64x2_t next(int r)
+  {
+    // ARMv7 NEON has no 64-bit multiply: x * 5 == (x << 2) + x, x * 9 == (x << 3) + x.
+    const auto m5 = vaddq_u64(vshlq_n_u64(s1_[r], 2), s1_[r]);
+    const auto rot = vshlcq_n_u64<7>(m5);
+    const auto ret = vaddq_u64(vshlq_n_u64(rot, 3), rot);
+    const auto t = vshlq_n_u64(s1_[r], 17);
+    s2_[r] = veorq_u64(s2_[r], s0_[r]);
+    s3_[r] = veorq_u64(s3_[r], s1_[r]);
+    s1_[r] = veorq_u64(s1_[r], s2_[r]);
+    s0_[r] = veorq_u64(s0_[r], s3_[r]);
+    s2_[r] = veorq_u64(s2_[r], t);
+    s3_[r] = vshlcq_n_u64<45>(s3_[r]);
+    return ret;
+  }
+
+  void get_stream(int k, uint64_t* s) const
+  {
+    const uint64x2_t* const regs[] = { s0_, s1_, s2_, s3_ };
+    for (int w = 0; w < 4; ++w) {
+      uint64_t lanes[2];
+      vst1q_u64(lanes, regs[w][k / 2]);
+      s[w] = lanes[k % 2];
+    }
+  }
+
+  void set_stream(int k, const uint64_t* s)
+  {
+    uint64x2_t* const regs[] = { s0_, s1_, s2_, s3_ };
+    for (int w = 0; w < 4; ++w) {
+      uint64_t lanes[2];
+      vst1q_u64(lanes, regs[w][k / 2]);
+      lanes[k % 2] = s[w];
+      regs[w][k / 2] = vld1q_u64(lanes);
+    }
+  }
+
+  uint64x2_t s0_[2], s1_[2], s2_[2], s3_[2];
+};
+
+// xoroshiro128+: 4 streams of uint64_t, two Q registers per state word.
+class neon_xoroshiro128p {
+public:
+  static const int kStreams = 4;
+
+  explicit neon_xoroshiro128p(uint64_t seed)
+  {
+    uint64_t s[2];
+    for (int w = 0; w < 2; ++w) {
+      s[w] = neon_xoshiro_detail::splitmix64(&seed);
+    }
+    for (int k = 0; k < kStreams; ++k) {
+      set_stream(k, s);
+      neon_xoshiro_detail::jump_xoroshiro128(s);
+    }
+  }
+
+  // Advances every stream by kStreams * 2^64 steps.
+  void jump()
+  {
+    for (int k = 0; k < kStreams; ++k) {
+      uint64_t s[2];
+      get_stream(k, s);
+      for (int j = 0; j < kStreams; ++j) {
+        neon_xoshiro_detail::jump_xoroshiro128(s);
+      }
+      set_stream(k, s);
+    }
+  }
+
+  void fill(uint64_t* buf, size_t n)
+  {
+    size_t i = 0;
+    for (; i + kStreams <= n; i += kStreams) {
+      vst1q_u64(buf + i, next(0));
+      vst1q_u64(buf + i + 2, next(1));
+    }
+    if (i < n) {
+      uint64_t tmp[kStreams];
+      vst1q_u64(tmp, next(0));
+      vst1q_u64(tmp + 2, next(1));
+      memcpy(buf + i, tmp, (n - i) * sizeof(uint64_t));
+    }
+  }
+
+  void fill_bytes(void* buf, size_t bytes)
+  {
+    auto d = static_cast<uint8_t*>(buf);
+    size_t i = 0;
+    for (; i + kStreams * 8 <= bytes; i += kStreams * 8) {
+      vst1q_u8(d + i, vreinterpretq_u8_u64(next(0)));
+      vst1q_u8(d + i + 16, vreinterpretq_u8_u64(next(1)));
+    }
+    if (i < bytes) {
+      uint64_t tmp[kStreams];
+      vst1q_u64(tmp, next(0));
+      vst1q_u64(tmp + 2, next(1));
+      memcpy(d + i, tmp, bytes - i);
+    }
+  }
+
+private:
+  uint64x2_t next(int r)
+  {
+    const auto s0 = s0_[r];
+    const auto s1 = veorq_u64(s1_[r], s0);
+    const auto ret = vaddq_u64(s0, s1_[r]);
+    s0_[r] = veorq_u64(veorq_u64(vshlcq_n_u64<24>(s0), s1), vshlq_n_u64(s1, 16));
+    s1_[r] = vshlcq_n_u64<37>(s1);
+    return ret;
+  }
+
+  void get_stream(int k, uint64_t* s) const
+  {
+    const uint64x2_t* const regs[] = { s0_, s1_ };
+    for (int w = 0; w < 2; ++w) {
+      uint64_t lanes[2];
+      vst1q_u64(lanes, regs[w][k / 2]);
+      s[w] = lanes[k % 2];
+    }
+  }
+
+  void set_stream(int k, const uint64_t* s)
+  {
+    uint64x2_t* const regs[] = { s0_, s1_ };
+    for (int w = 0; w < 2; ++w) {
+      uint64_t lanes[2];
+      vst1q_u64(lanes, regs[w][k / 2]);
+      lanes[k % 2] = s[w];
+      regs[w][k / 2] = vld1q_u64(lanes);
+    }
+  }
+
+  uint64x2_t s0_[2], s1_[2];
+};
+
+#endif /* NEON_XOSHIRO_H */
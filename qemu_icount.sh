@@ -0,0 +1,49 @@
+#!/bin/sh -eu
+#
+# Retired instructions per element for every benchmark case, counted under
+# qemu-user with the TCG "insn" plugin. Unlike timings the counts are exact
+# and reproducible, so they can be compared across commits on any host.
+#
+#   QEMU_PLUGIN=/path/to/libinsn.so ./qemu_icount.sh build/app ['u32/*'] [16K]
+#
+# QEMU (default qemu-arm) runs the binary; QEMU_LD_PREFIX points it at the
+# target's sysroot when the binary is not static. The plugin counts the whole
+# process, so every case runs twice, with 1 and 1 + REPS calls, and only the
+# difference is reported.
+
+APP=$1
+FILTER=${2:-*}
+SIZE=${3:-16K}
+QEMU=${QEMU:-qemu-arm}
+REPS=${REPS:-16}
+: "${QEMU_PLUGIN:?set QEMU_PLUGIN to the path of libinsn.so}"
+
+if [ -n "${QEMU_LD_PREFIX:-}" ]; then
+  set -- -L "$QEMU_LD_PREFIX"
+else
+  set --
+fi
+
+insns()
+{
+  "$QEMU" "$@" -plugin "$QEMU_PLUGIN" -d plugin "$APP" --no-test --select "$NAME:$N" \
+    --sizes "$BYTES" --icount "$CALLS" 2>&1 >"$OUT" </dev/null | sed -n 's/.*insns: *\([0-9]*\).*/\1/p' | tail -n 1
+}
+
+OUT=$(mktemp)
+trap 'rm -f "$OUT"' EXIT
+
+echo "name,width,n,size,elems,insns_per_call,insns_per_elem"
+"$QEMU" "$@" "$APP" --no-test --list --filter "$FILTER" --sizes "$SIZE" |
+while read -r NAME WIDTH N BYTES; do
+  CALLS=1
+  A=$(insns "$@")
+  CALLS=$((1 + REPS))
+  B=$(insns "$@")
+  ELEMS=$(awk -F, -v name="$NAME" -v n="$N" '$1 == name && $3 == n { print $5 }' "$OUT")
+  awk -v a="$A" -v b="$B" -v reps="$REPS" -v elems="$ELEMS" \
+      -v prefix="$NAME,$WIDTH,$N,$BYTES,$ELEMS" 'BEGIN {
+    per_call = (b - a) / reps
+    printf "%s,%.1f,%.3f\n", prefix, per_call, per_call / (elems > 0 ? elems : 1)
+  }'
+done
@@ -0,0 +1,165 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "neon_circular_shift_arena.h"
+#include "neon_circular_shift_bulk.h"
+#include "neon_xoshiro.h"
+#include "test_bulk_state.h"
+#include "test_common.h"
+
+static void test_alloc(bool huge_pages)
+{
+  static const size_t kSizes[] = { 1, 63, 64, 100, 4096, 70000, 3 << 20 };
+  shlc_arena arena(huge_pages);
+  std::vector<void*> first;
+  size_t capacity = 0;
+  for (int round = 0; round < 3; ++round) {
+    std::vector<void*> got;
+    for (const auto size : kSizes) {
+      auto* p = static_cast<char*>(arena.alloc(size));
+      if (!p || reinterpret_cast<uintptr_t>(p) % shlc_arena::kAlign != 0) {
+        printf("arena: huge %d size %zu: %p\n", huge_pages, size, static_cast<void*>(p));
+        return;
+      }
+      memset(p, round, size);
+      got.push_back(p);
+    }
+    // Buffers do not overlap: each still holds its own first byte.
+    for (size_t i = 0; i < got.size(); ++i) {
+      static_cast<char*>(got[i])[0] = static_cast<char>(i);
+    }
+    for (size_t i = 0; i < got.size(); ++i) {
+      if (static_cast<char*>(got[i])[0] != static_cast<char>(i)) {
+        printf("arena: huge %d: buffer %zu overwritten\n", huge_pages, i);
+      }
+    }
+    // After the first round everything fits in the merged mapping.
+    if (round == 1) {
+      first = got;
+      capacity = arena.capacity();
+    } else if (round == 2 && (got != first || arena.capacity() != capacity)) {
+      printf("arena: huge %d: round %d mapped again\n", huge_pages, round);
+    }
+    arena.reset();
+  }
+}
+
+// The aligned kernels, used for arena buffers, against the unaligned ones.
+template<typename T>
+static void test_bulk_aligned(void)
+{
+  static const int kBits = 8 * sizeof(T);
+  static const size_t kLen = 1000;
+  shlc_arena arena;
+  std::vector<T> src(kLen), dst1(kLen);
+  neon_xoshiro128pp rng(1000);
+  rng.fill_bytes(src.data(), kLen * sizeof(T));
+  for (const auto offset : { 0, 1 }) {
+    T* s = arena.alloc<T>(kLen + 1) + offset;
+    T* d = arena.alloc<T>(kLen + 1) + offset;
+    memcpy(s, src.data(), kLen * sizeof(T));
+    for (int n = 1; n < kBits; ++n) {
+      for (size_t i = 0; i < kLen; ++i) {
+        dst1[i] = static_cast<T>((src[i] << n) | (src[i] >> (kBits - n)));
+      }
+      switch (kBits) {
+      case 8:
+        shlc_bulk_u8(reinterpret_cast<const uint8_t*>(s), reinterpret_cast<uint8_t*>(d), kLen, n);
+        break;
+      case 16:
+        shlc_bulk_u16(reinterpret_cast<const uint16_t*>(s), reinterpret_cast<uint16_t*>(d), kLen, n);
+        break;
+      case 32:
+        shlc_bulk_u32(reinterpret_cast<const uint32_t*>(s), reinterpret_cast<uint32_t*>(d), kLen, n);
+        break;
+      case 64:
+        shlc_bulk_u64(reinterpret_cast<const uint64_t*>(s), reinterpret_cast<uint64_t*>(d), kLen, n);
+        break;
+      }
+      validate(dst1, std::vector<T>(d, d + kLen), kLen);
+    }
+    arena.reset();
+  }
+}
+
+void test_arena(void)
+{
+  test_alloc(false);
+  test_alloc(true);
+  // The aligned kernels belong to the neon backend, which an SVE2 or SHA3
+  // machine would not choose on its own.
+  if (!shlc_bulk_supported(shlc_backend::neon)) {
+    return;
+  }
+  const bulk_state saved;
+  shlc_bulk_force_backend(shlc_backend::neon);
+  for (const auto unroll : { 1, 4 }) {
+    shlc_bulk_config c;
+    c.unroll = unroll;
+    for (const auto width : { 8, 16, 32, 64 }) {
+      shlc_bulk_set_config(width, c);
+    }
+    test_bulk_aligned<uint8_t>();
+    test_bulk_aligned<uint16_t>();
+    test_bulk_aligned<uint32_t>();
+    test_bulk_aligned<uint64_t>();
+  }
+  saved.restore();
+}
+
+// shlc_bulk_u32 with the neon backend on arena buffers: 8 bytes off a line,
+// so that every other vector splits one; aligned with the plain kernels;
+// aligned with the aligned ones; and the same on huge pages. Each case pins
+// the backend to neon and turns the streaming kernels off, so that the large
+// sizes compare the same loops; the rest of the u32 configuration stays as
+// it was, and the cap and configuration are put back when the case is done.
+static bench_case arena_case(const std::string& name, bool huge_pages, size_t offset, bool aligned)
+{
+  bench_case c;
+  c.name = name;
+  c.width = 32;
+  c.n = 5;
+  c.prepare = [huge_pages, offset, aligned](size_t bytes) {
+    const bulk_state saved;
+    shlc_bulk_force_backend(shlc_backend::neon);
+    auto config = shlc_bulk_get_config(32);
+    config.aligned = aligned;
+    config.stream = SIZE_MAX;
+    shlc_bulk_set_config(32, config);
+    auto len = bytes / (2 * sizeof(uint32_t)) & ~static_cast<size_t>(15);
+    len = len ? len : 16;
+    auto arena = std::make_shared<shlc_arena>(huge_pages);
+    auto* src = reinterpret_cast<uint32_t*>(static_cast<char*>(arena->alloc(len * sizeof(uint32_t) + offset)) + offset);
+    auto* dst = reinterpret_cast<uint32_t*>(static_cast<char*>(arena->alloc(len * sizeof(uint32_t) + offset)) + offset);
+    neon_xoshiro128pp rng(1000);
+    rng.fill_bytes(src, len * sizeof(uint32_t));
+    memset(dst, 0, len * sizeof(uint32_t));
+    bench_run r;
+    r.run = [arena, src, dst, len]() {
+      shlc_bulk_u32(src, dst, len, 5);
+      bench_do_not_optimize(dst);
+    };
+    r.elems = len;
+    r.bytes = 2 * len * sizeof(uint32_t);
+    r.counters.push_back({ "hugetlb", arena->hugetlb() ? 1 : 0 });
+    r.teardown = [saved]() {
+      saved.restore();
+    };
+    return r;
+  };
+  return c;
+}
+
+void perf_arena(bench_registry* bench)
+{
+  bench->add(arena_case("u32/arena/offset8", false, 8, true));
+  bench->add(arena_case("u32/arena/aligned/plain", false, 0, false));
+  bench->add(arena_case("u32/arena/aligned/hint", false, 0, true));
+  bench->add(arena_case("u32/arena/huge/hint", true, 0, true));
+}
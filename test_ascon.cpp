@@ -0,0 +1,302 @@
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+#include <cstring>
+
+#include <arm_neon.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "neon_ascon.h"
+#include "neon_xoshiro.h"
+#include "test_common.h"
+
+static uint64_t ror64(uint64_t x, int r)
+{
+  return (x >> r) | (x << (64 - r));
+}
+
+static uint64_t load64(const uint8_t* p, size_t n)
+{
+  uint64_t v = 0;
+  for (size_t i = 0; i < n; ++i) {
+    v |= static_cast<uint64_t>(p[i]) << (56 - 8 * i);
+  }
+  return v;
+}
+
+static void store64(uint8_t* p, uint64_t v, size_t n)
+{
+  for (size_t i = 0; i < n; ++i) {
+    p[i] = static_cast<uint8_t>(v >> (56 - 8 * i));
+  }
+}
+
+static void ascon_p_pure_c(uint64_t* s, int rounds)
+{
+  for (int r = 12 - rounds; r < 12; ++r) {
+    s[2] ^= ((0xfULL - r) << 4) | r;
+    s[0] ^= s[4]; s[4] ^= s[3]; s[2] ^= s[1];
+    uint64_t t[5];
+    for (int i = 0; i < 5; ++i) {
+      t[i] = ~s[i] & s[(i + 1) % 5];
+    }
+    for (int i = 0; i < 5; ++i) {
+      s[i] ^= t[(i + 1) % 5];
+    }
+    s[1] ^= s[0]; s[0] ^= s[4]; s[3] ^= s[2]; s[2] = ~s[2];
+    s[0] ^= ror64(s[0], 19) ^ ror64(s[0], 28);
+    s[1] ^= ror64(s[1], 61) ^ ror64(s[1], 39);
+    s[2] ^= ror64(s[2], 1) ^ ror64(s[2], 6);
+    s[3] ^= ror64(s[3], 10) ^ ror64(s[3], 17);
+    s[4] ^= ror64(s[4], 7) ^ ror64(s[4], 41);
+  }
+}
+
+static void ascon128_seal_pure_c(const uint8_t* key, const uint8_t* nonce, const uint8_t* ad, size_t ad_len,
+                                 const uint8_t* pt, size_t len, uint8_t* ct, uint8_t* tag)
+{
+  const uint64_t k0 = load64(key, 8), k1 = load64(key + 8, 8);
+  uint64_t s[5] = { 0x80400c0600000000ULL, k0, k1, load64(nonce, 8), load64(nonce + 8, 8) };
+  ascon_p_pure_c(s, 12);
+  s[3] ^= k0;
+  s[4] ^= k1;
+  if (ad_len) {
+    for (; ad_len >= 8; ad += 8, ad_len -= 8) {
+      s[0] ^= load64(ad, 8);
+      ascon_p_pure_c(s, 6);
+    }
+    s[0] ^= load64(ad, ad_len) ^ (0x80ULL << (56 - 8 * ad_len));
+    ascon_p_pure_c(s, 6);
+  }
+  s[4] ^= 1;
+  for (; len >= 8; pt += 8, ct += 8, len -= 8) {
+    s[0] ^= load64(pt, 8);
+    store64(ct, s[0], 8);
+    ascon_p_pure_c(s, 6);
+  }
+  s[0] ^= load64(pt, len) ^ (0x80ULL << (56 - 8 * len));
+  store64(ct, s[0], len);
+  s[1] ^= k0;
+  s[2] ^= k1;
+  ascon_p_pure_c(s, 12);
+  store64(tag, s[3] ^ k0, 8);
+  store64(tag + 8, s[4] ^ k1, 8);
+}
+
+static void ascon_hash_pure_c(const uint8_t* msg, size_t len, uint8_t* digest)
+{
+  uint64_t s[5] = { 0x00400c0000000100ULL, 0, 0, 0, 0 };
+  ascon_p_pure_c(s, 12);
+  for (; len >= 8; msg += 8, len -= 8) {
+    s[0] ^= load64(msg, 8);
+    ascon_p_pure_c(s, 12);
+  }
+  s[0] ^= load64(msg, len) ^ (0x80ULL << (56 - 8 * len));
+  for (int i = 0; i < 4; ++i) {
+    ascon_p_pure_c(s, 12);
+    store64(digest + 8 * i, s[0], 8);
+  }
+}
+
+static std::vector<uint8_t> from_hex(const char* hex)
+{
+  std::vector<uint8_t> v;
+  for (; hex[0] && hex[1]; hex += 2) {
+    unsigned b;
+    sscanf(hex, "%2x", &b);
+    v.push_back(static_cast<uint8_t>(b));
+  }
+  return v;
+}
+
+// LWC_AEAD_KAT_128_128.txt (Count 1, 2, 34) and LWC_HASH_KAT_256.txt (Count 1, 2)
+// of the Ascon v1.2 submission: key and nonce are 00 01 .. 0f.
+static void test_kat(void)
+{
+  static const struct {
+    const char* ad;
+    const char* pt;
+    const char* ct;
+  } kAead[] = {
+    { "", "", "E355159F292911F794CB1432A0103A8A" },
+    { "00", "", "944DF887CD4901614C5DEDBC42FC0DA0" },
+    { "", "00", "BC18C3F4E39ECA7222490D967C79BFFC92" },
+  };
+  static const struct {
+    const char* msg;
+    const char* md;
+  } kHash[] = {
+    { "", "7346BC14F036E87AE03D0997913088F5F68411434B3CF8B54FA796A80D251F91" },
+    { "00", "8DD446ADA58A7740ECF56EB638EF775F7D5C0FD5F0C2BBBDFDEC29609D3C43A2" },
+  };
+  uint8_t key[16], nonce[16];
+  for (int i = 0; i < 16; ++i) {
+    key[i] = nonce[i] = static_cast<uint8_t>(i);
+  }
+  const neon_ascon128 ascon(key);
+
+  for (const auto& kat : kAead) {
+    const auto ad = from_hex(kat.ad);
+    const auto pt = from_hex(kat.pt);
+    const auto expected = from_hex(kat.ct);
+    std::vector<uint8_t> ref(pt.size() + 16), out(pt.size() + 16), opened(pt.size());
+    ascon128_seal_pure_c(key, nonce, ad.data(), ad.size(), pt.data(), pt.size(), ref.data(), ref.data() + pt.size());
+    ascon.seal(nonce, ad.data(), ad.size(), pt.data(), pt.size(), out.data(), out.data() + pt.size());
+    validate(expected, ref, expected.size());
+    validate(expected, out, expected.size());
+    if (!ascon.open(nonce, ad.data(), ad.size(), out.data(), pt.size(), opened.data(), out.data() + pt.size())) {
+      printf("%s: KAT open failed\n", __FUNCTION__);
+    }
+    validate(pt, opened, pt.size());
+  }
+
+  for (const auto& kat : kHash) {
+    const auto msg = from_hex(kat.msg);
+    const auto expected = from_hex(kat.md);
+    std::vector<uint8_t> ref(32), out(32);
+    ascon_hash_pure_c(msg.data(), msg.size(), ref.data());
+    neon_ascon_hash(msg.data(), msg.size(), out.data());
+    validate(expected, ref, 32);
+    validate(expected, out, 32);
+  }
+}
+
+// Messages with lengths spread over 0 .. 2 * kMaxLen and with or without
+// associated data, sealed, opened and hashed through the bulk APIs.
+static void test_bulk(void)
+{
+  static const size_t kMsgs = 101;
+  static const size_t kMaxLen = 100;
+  neon_xoshiro128pp rng(1000);
+  uint8_t key[16];
+  rng.fill_bytes(key, sizeof(key));
+  const neon_ascon128 ascon(key);
+
+  std::vector<std::vector<uint8_t>> nonce(kMsgs), ad(kMsgs), pt(kMsgs), ct(kMsgs), ref(kMsgs), opened(kMsgs);
+  std::vector<uint8_t> tags(16 * kMsgs), ref_tags(16 * kMsgs), digests(32 * kMsgs), ref_digests(32 * kMsgs);
+  std::vector<neon_ascon_aead_job> seal_jobs(kMsgs), open_jobs(kMsgs);
+  std::vector<neon_ascon_hash_job> hash_jobs(kMsgs);
+  for (size_t i = 0; i < kMsgs; ++i) {
+    nonce[i].resize(16);
+    ad[i].resize(i % 3 == 0 ? 0 : i % 19);
+    pt[i].resize(i % 2 ? i : 2 * kMaxLen - i);
+    ct[i].resize(pt[i].size());
+    ref[i].resize(pt[i].size());
+    opened[i].resize(pt[i].size());
+    rng.fill_bytes(nonce[i].data(), 16);
+    rng.fill_bytes(ad[i].data(), ad[i].size());
+    rng.fill_bytes(pt[i].data(), pt[i].size());
+    ascon128_seal_pure_c(key, nonce[i].data(), ad[i].data(), ad[i].size(), pt[i].data(), pt[i].size(),
+                         ref[i].data(), &ref_tags[16 * i]);
+    ascon_hash_pure_c(pt[i].data(), pt[i].size(), &ref_digests[32 * i]);
+    seal_jobs[i] = { nonce[i].data(), ad[i].data(), ad[i].size(), pt[i].data(), pt[i].size(), ct[i].data(), &tags[16 * i] };
+    open_jobs[i] = { nonce[i].data(), ad[i].data(), ad[i].size(), ct[i].data(), ct[i].size(), opened[i].data(), &tags[16 * i] };
+    hash_jobs[i] = { pt[i].data(), pt[i].size(), &digests[32 * i] };
+  }
+
+  ascon.seal(seal_jobs.data(), kMsgs);
+  validate(ref_tags, tags, tags.size());
+  for (size_t i = 0; i < kMsgs; ++i) {
+    validate(ref[i], ct[i], ct[i].size());
+  }
+
+  bool ok[kMsgs];
+  auto authentic = ascon.open(open_jobs.data(), kMsgs, ok);
+  if (authentic != kMsgs) {
+    printf("%s: %zu of %zu messages authentic\n", __FUNCTION__, authentic, kMsgs);
+  }
+  for (size_t i = 0; i < kMsgs; ++i) {
+    validate(pt[i], opened[i], pt[i].size());
+  }
+
+  // Forged messages are rejected and their output is cleared.
+  ct[10][0] ^= 1;
+  tags[16 * 11] ^= 1;
+  authentic = ascon.open(open_jobs.data(), kMsgs, ok);
+  if (authentic != kMsgs - 2 || ok[10] || ok[11] || !ok[12] ||
+      opened[10] != std::vector<uint8_t>(opened[10].size())) {
+    printf("%s: forgery not detected\n", __FUNCTION__);
+  }
+
+  neon_ascon_hash(hash_jobs.data(), kMsgs);
+  validate(ref_digests, digests, digests.size());
+}
+
+void test_ascon(void)
+{
+  test_kat();
+  test_bulk();
+}
+
+// Messages of kMsgLen bytes, sealed into dst or hashed into digests.
+struct ascon_bench {
+  static const size_t kMsgLen = 1500;
+
+  explicit ascon_bench(size_t n)
+      : msgs(n), src(n * kMsgLen), dst(n * kMsgLen), tags(16 * n), digests(32 * n),
+        jobs(n), hash_jobs(n), key(), nonce(), ascon(key)
+  {
+    neon_xoshiro128pp rng(1000);
+    rng.fill_bytes(src.data(), src.size());
+    for (size_t i = 0; i < n; ++i) {
+      jobs[i] = { nonce, nullptr, 0, &src[i * kMsgLen], kMsgLen, &dst[i * kMsgLen], &tags[16 * i] };
+      hash_jobs[i] = { &src[i * kMsgLen], kMsgLen, &digests[32 * i] };
+    }
+  }
+
+  size_t msgs;
+  std::vector<uint8_t> src, dst, tags, digests;
+  std::vector<neon_ascon_aead_job> jobs;
+  std::vector<neon_ascon_hash_job> hash_jobs;
+  uint8_t key[16], nonce[16];
+  const neon_ascon128 ascon;
+};
+
+static void perf_msgs(bench_registry* bench, const std::string& name, bench_traffic traffic,
+                      void (*func)(ascon_bench*))
+{
+  bench_case c;
+  c.name = name;
+  c.prepare = [func, traffic](size_t bytes) {
+    const auto msgs = std::max<size_t>(bytes / (2 * ascon_bench::kMsgLen), 1);
+    auto state = std::make_shared<ascon_bench>(msgs);
+    bench_run r;
+    r.run = [func, state]() {
+      func(state.get());
+      bench_do_not_optimize(state->tags.data());
+      bench_do_not_optimize(state->digests.data());
+    };
+    r.elems = msgs;
+    // Sealing reads and writes each message, hashing only reads it.
+    r.bytes = (traffic == bench_traffic::copy ? 2 : 1) * msgs * ascon_bench::kMsgLen;
+    r.traffic = traffic;
+    return r;
+  };
+  bench->add(c);
+}
+
+void perf_ascon(bench_registry* bench)
+{
+  perf_msgs(bench, "ascon/seal/pure_c", bench_traffic::copy, [](ascon_bench* b) {
+    for (size_t i = 0; i < b->msgs; ++i) {
+      const auto& j = b->jobs[i];
+      ascon128_seal_pure_c(b->key, b->nonce, nullptr, 0, j.in, j.len, j.out, j.tag);
+    }
+  });
+  perf_msgs(bench, "ascon/seal/neon", bench_traffic::copy, [](ascon_bench* b) {
+    b->ascon.seal(b->jobs.data(), b->msgs);
+  });
+  perf_msgs(bench, "ascon/hash/pure_c", bench_traffic::read, [](ascon_bench* b) {
+    for (size_t i = 0; i < b->msgs; ++i) {
+      ascon_hash_pure_c(b->hash_jobs[i].msg, b->hash_jobs[i].len, b->hash_jobs[i].digest);
+    }
+  });
+  perf_msgs(bench, "ascon/hash/neon", bench_traffic::read, [](ascon_bench* b) {
+    neon_ascon_hash(b->hash_jobs.data(), b->msgs);
+  });
+}
@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <cstdint>
+
+#include <vector>
+
+#include "bench_baselines.h"
+#include "neon_xoshiro.h"
+#include "test_common.h"
+
+// The compiler baselines against the reference, so that a wrong one does not
+// pass for a fast one in the speedup ratios.
+
+template<typename T>
+static T rotl_pure_c(T v, int n)
+{
+  static const int kBits = 8 * sizeof(T);
+  n = ((n % kBits) + kBits) % kBits;
+  return n == 0 ? v : static_cast<T>((v << n) | (v >> (kBits - n)));
+}
+
+template<typename T, int n>
+static void test_shift(const std::vector<T>& src)
+{
+  using namespace bench_baselines_detail;
+  const auto len = src.size();
+  std::vector<T> ref(len), dst(len);
+  for (size_t i = 0; i < len; ++i) {
+    ref[i] = rotl_pure_c(src[i], n);
+  }
+#ifdef __cpp_lib_bitops
+  std_rotl_loop<T, n>(src.data(), dst.data(), len);
+  validate(ref, dst, len);
+#endif
+#ifdef BENCH_HAVE_BUILTIN_ROTATELEFT
+  builtin_rotl_loop<T, n>(src.data(), dst.data(), len);
+  validate(ref, dst, len);
+#endif
+  vector_loop<T, n>(src.data(), dst.data(), len);
+  validate(ref, dst, len);
+}
+
+template<typename T>
+static void test_type(void)
+{
+  static const int kBits = 8 * sizeof(T);
+  std::vector<T> src(4096);
+  neon_xoshiro128pp rng(1000 + kBits);
+  rng.fill_bytes(src.data(), src.size() * sizeof(T));
+  test_shift<T, 1>(src);
+  // 8 is a full turn of u8, which the baselines are not registered for.
+  test_shift<T, (kBits > 8 ? 8 : 3)>(src);
+  test_shift<T, kBits / 2>(src);
+  test_shift<T, kBits - 1>(src);
+}
+
+void test_baselines(void)
+{
+  test_type<uint8_t>();
+  test_type<uint16_t>();
+  test_type<uint32_t>();
+  test_type<uint64_t>();
+}
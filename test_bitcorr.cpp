@@ -0,0 +1,135 @@
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+
+#include <arm_neon.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "neon_bitcorr.h"
+#include "neon_xoshiro.h"
+#include "test_common.h"
+
+static int get_bit(const std::vector<uint32_t>& v, size_t i)
+{
+  return (v[i / 32] >> (i % 32)) & 1;
+}
+
+static void bitcorr_pure_c(const std::vector<uint32_t>& ref, const std::vector<uint32_t>& rx, size_t bits,
+                           std::vector<uint32_t>* corr)
+{
+  for (size_t s = 0; s < bits; ++s) {
+    uint32_t c = 0;
+    for (size_t i = 0; i < bits; ++i) {
+      c += get_bit(rx, i) == get_bit(ref, (i + s) % bits);
+    }
+    (*corr)[s] = c;
+  }
+}
+
+// Word-at-a-time baseline: funnel-shift the doubled reference for each rotation.
+static void bitcorr_words_pure_c(const std::vector<uint32_t>& doubled, const std::vector<uint32_t>& rx,
+                                 size_t bits, std::vector<uint32_t>* corr)
+{
+  const auto words = bits / 32;
+  for (size_t s = 0; s < bits; ++s) {
+    const auto q = s / 32;
+    const auto b = s % 32;
+    uint32_t dist = 0;
+    for (size_t j = 0; j < words; ++j) {
+      const auto w = b ? (doubled[q + j] >> b) | (doubled[q + j + 1] << (32 - b)) : doubled[q + j];
+      dist += __builtin_popcount(rx[j] ^ w);
+    }
+    (*corr)[s] = static_cast<uint32_t>(bits - dist);
+  }
+}
+
+static void test_bits(size_t bits)
+{
+  const auto words = (bits + 31) / 32;
+  std::vector<uint32_t> ref(words), noise(words), rx(words);
+  neon_xoshiro128pp rng(1000 + bits);
+  rng.fill(ref.data(), words);
+  rng.fill(noise.data(), words);
+
+  // The received block is the code rotated by `shift` with every 8th bit or
+  // so flipped.
+  const auto shift = bits * 2 / 3;
+  for (size_t i = 0; i < bits; ++i) {
+    const auto flip = (noise[i / 32] >> (i % 32)) & (i % 8 == 3);
+    rx[i / 32] |= static_cast<uint32_t>(get_bit(ref, (i + shift) % bits) ^ flip) << (i % 32);
+  }
+
+  std::vector<uint32_t> corr1(bits), corr2(bits);
+  bitcorr_pure_c(ref, rx, bits, &corr1);
+  const neon_bitcorr corr(ref.data(), bits);
+  corr.correlate(rx.data(), corr2.data());
+  validate(corr1, corr2, bits);
+
+  if (neon_bitcorr_peak(corr2.data(), bits) != shift) {
+    printf("test_bitcorr: %zu bits, peak %zu, expected %zu\n", bits, neon_bitcorr_peak(corr2.data(), bits), shift);
+  }
+  size_t top[3];
+  neon_bitcorr_top_k(corr2.data(), bits, 3, top);
+  if (top[0] != shift || corr2[top[1]] < corr2[top[2]] || corr2[top[1]] > corr2[top[0]]) {
+    printf("test_bitcorr: %zu bits, bad top-k\n", bits);
+  }
+}
+
+void test_bitcorr(void)
+{
+  static const size_t sizes[] = { 32, 33, 63, 64, 65, 96, 100, 127, 128, 129, 1000, 4096, 5003 };
+  for (const auto bits : sizes) {
+    test_bits(bits);
+  }
+}
+
+// Sizes are code lengths in bytes; one call correlates against every rotation.
+static void perf_corr(bench_registry* bench, const std::string& name, bool neon)
+{
+  bench_case c;
+  c.name = name;
+  c.width = 1;
+  c.sizes = { 8, 128, 2048, 8192 };
+  c.prepare = [neon](size_t bytes) {
+    const auto bits = std::max<size_t>(bytes / 4 * 32, 32);
+    const auto words = bits / 32;
+    std::vector<uint32_t> ref(words);
+    auto rx = std::make_shared<std::vector<uint32_t>>(words);
+    auto out = std::make_shared<std::vector<uint32_t>>(bits);
+    neon_xoshiro128pp rng(1000);
+    rng.fill(ref.data(), words);
+    rng.fill(rx->data(), words);
+    bench_run r;
+    if (neon) {
+      auto corr = std::make_shared<neon_bitcorr>(ref.data(), bits);
+      r.run = [corr, rx, out]() {
+        corr->correlate(rx->data(), out->data());
+        bench_do_not_optimize(out->data());
+      };
+    } else {
+      auto doubled = std::make_shared<std::vector<uint32_t>>(ref);
+      doubled->insert(doubled->end(), ref.begin(), ref.end());
+      doubled->push_back(ref[0]);
+      r.run = [doubled, rx, out, bits]() {
+        bitcorr_words_pure_c(*doubled, *rx, bits, out.get());
+        bench_do_not_optimize(out->data());
+      };
+    }
+    r.elems = bits;
+    // The received word in, one count per rotation out.
+    r.bytes = bits / 8 + bits * sizeof(uint32_t);
+    return r;
+  };
+  bench->add(c);
+}
+
+void perf_bitcorr(bench_registry* bench)
+{
+  perf_corr(bench, "bitcorr/pure_c", false);
+  perf_corr(bench, "bitcorr/neon", true);
+}
@@ -0,0 +1,184 @@
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+
+#include <arm_neon.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "neon_bloom.h"
+#include "neon_xoshiro.h"
+#include "test_common.h"
+
+static uint32_t rotl_pure_c(uint32_t v, int n)
+{
+  return (v << n) | (v >> (32 - n));
+}
+
+// The same filter with one probe at a time.
+class bloom_pure_c {
+public:
+  explicit bloom_pure_c(size_t bytes) : blocks_((bytes + 63) / 64), words_(blocks_ * 8, 0)
+  {
+  }
+
+  void insert(uint64_t key)
+  {
+    uint64_t* block;
+    uint32_t p[8];
+    probes(key, &block, p);
+    for (int i = 0; i < 8; ++i) {
+      block[i] |= 1ULL << (p[i] >> 26);
+    }
+  }
+
+  bool contains(uint64_t key)
+  {
+    uint64_t* block;
+    uint32_t p[8];
+    probes(key, &block, p);
+    for (int i = 0; i < 8; ++i) {
+      if (!(block[i] & (1ULL << (p[i] >> 26)))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  void probes(uint64_t key, uint64_t** block, uint32_t* p)
+  {
+    auto h = key;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    const auto h1 = static_cast<uint32_t>(h);
+    const auto h2 = h1 * 0x9e3779b1U;
+    *block = words_.data() + 8 * (((h >> 32) * blocks_) >> 32);
+    for (int i = 0; i < 8; ++i) {
+      p[i] = rotl_pure_c(h1, 4 * i + 2) ^ h2;
+    }
+  }
+
+  size_t blocks_;
+  std::vector<uint64_t> words_;
+};
+
+static void test_filter(size_t bytes, size_t keys)
+{
+  std::vector<uint64_t> inserted(keys), queried(4 * keys);
+  neon_xoshiro256ss rng(1000 + bytes);
+  rng.fill(inserted.data(), keys);
+  rng.fill(queried.data(), queried.size());
+  for (size_t i = 0; i < keys; ++i) {
+    queried[4 * i] = inserted[i];
+  }
+
+  bloom_pure_c ref(bytes);
+  neon_bloom_filter filter(bytes);
+  for (const auto k : inserted) {
+    ref.insert(k);
+  }
+  // Odd batch sizes, and single keys.
+  filter.insert(inserted.data(), keys / 2);
+  filter.insert(inserted.data() + keys / 2, 1);
+  filter.insert(inserted.data() + keys / 2 + 1, keys - keys / 2 - 1);
+
+  std::vector<uint8_t> expected(queried.size()), found(queried.size());
+  for (size_t i = 0; i < queried.size(); ++i) {
+    expected[i] = ref.contains(queried[i]);
+  }
+  filter.contains(queried.data(), queried.size(), found.data());
+  validate(expected, found, queried.size());
+
+  // Copies have blocks of their own.
+  neon_bloom_filter copy(filter);
+  neon_bloom_filter assigned(64);
+  assigned = filter;
+  filter.clear();
+  copy.contains(queried.data(), queried.size(), found.data());
+  validate(expected, found, queried.size());
+  assigned.contains(queried.data(), queried.size(), found.data());
+  validate(expected, found, queried.size());
+  filter = std::move(assigned);
+
+  for (size_t i = 0; i < keys; ++i) {
+    if (!filter.contains(inserted[i])) {
+      printf("test_bloom: key %zu missing\n", i);
+      break;
+    }
+  }
+}
+
+void test_bloom(void)
+{
+  test_filter(64, 3);
+  test_filter(4096, 300);
+  test_filter(100000, 80001);
+}
+
+// Sizes are filter sizes, with 10 bits per inserted key; one call queries
+// kQueries random keys.
+static void perf_filter(bench_registry* bench, const std::string& name, bool neon)
+{
+  static const size_t kQueries = 65536;
+  bench_case c;
+  c.name = name;
+  c.width = 64;
+  c.sizes = { 64*1024, 1024*1024, 16*1024*1024 };
+  c.prepare = [neon](size_t bytes) {
+    const auto keys = std::max<size_t>(bytes * 8 / 10, 1);
+    std::vector<uint64_t> inserted(keys);
+    auto queried = std::make_shared<std::vector<uint64_t>>(kQueries);
+    auto found = std::make_shared<std::vector<uint8_t>>(kQueries);
+    neon_xoshiro256ss rng(1000);
+    rng.fill(inserted.data(), keys);
+    rng.fill(queried->data(), kQueries);
+
+    bench_run r;
+    if (neon) {
+      auto filter = std::make_shared<neon_bloom_filter>(bytes);
+      filter->insert(inserted.data(), keys);
+      r.run = [filter, queried, found]() {
+        filter->contains(queried->data(), kQueries, found->data());
+        bench_do_not_optimize(found->data());
+      };
+    } else {
+      auto ref = std::make_shared<bloom_pure_c>(bytes);
+      for (const auto k : inserted) {
+        ref->insert(k);
+      }
+      r.run = [ref, queried, found]() {
+        for (size_t i = 0; i < kQueries; ++i) {
+          (*found)[i] = ref->contains((*queried)[i]);
+        }
+        bench_do_not_optimize(found->data());
+      };
+    }
+    r.run();
+    size_t positives = 0;
+    for (const auto f : *found) {
+      positives += f;
+    }
+    r.elems = kQueries;
+    // One cache line per query.
+    r.bytes = 64 * kQueries;
+    r.traffic = bench_traffic::read;
+    r.counters.push_back({ "fpr", static_cast<double>(positives) / kQueries });
+    return r;
+  };
+  bench->add(c);
+}
+
+void perf_bloom(bench_registry* bench)
+{
+  perf_filter(bench, "bloom/pure_c", false);
+  perf_filter(bench, "bloom/neon", true);
+}
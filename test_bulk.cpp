@@ -0,0 +1,350 @@
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+#include <cstring>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "neon_circular_shift_bulk.h"
+#include "neon_circular_shift_stats.h"
+#include "neon_circular_shift_tune.h"
+#include "neon_xoshiro.h"
+#include "test_bulk_state.h"
+#include "test_common.h"
+
+static const shlc_backend kBackends[] = {
+  shlc_backend::c, shlc_backend::neon, shlc_backend::sha3, shlc_backend::sve2,
+};
+
+template<typename T>
+static T rotl_pure_c(T v, int n)
+{
+  static const int kBits = 8 * sizeof(T);
+  n = ((n % kBits) + kBits) % kBits;
+  return n == 0 ? v : static_cast<T>((v << n) | (v >> (kBits - n)));
+}
+
+static void shlc_bulk(const uint8_t* s, uint8_t* d, size_t len, int n)
+{
+  shlc_bulk_u8(s, d, len, n);
+}
+
+static void shlc_bulk(const uint16_t* s, uint16_t* d, size_t len, int n)
+{
+  shlc_bulk_u16(s, d, len, n);
+}
+
+static void shlc_bulk(const uint32_t* s, uint32_t* d, size_t len, int n)
+{
+  shlc_bulk_u32(s, d, len, n);
+}
+
+static void shlc_bulk(const uint64_t* s, uint64_t* d, size_t len, int n)
+{
+  shlc_bulk_u64(s, d, len, n);
+}
+
+template<typename T>
+static void test_type(void)
+{
+  static const int kBits = 8 * sizeof(T);
+  static const size_t kLens[] = { 0, 1, 15, 17, 1000, 4099 };
+  for (const auto len : kLens) {
+    std::vector<T> src(len), dst1(len), dst2(len);
+    neon_xoshiro128pp rng(1000 + len);
+    rng.fill_bytes(src.data(), len * sizeof(T));
+    for (int n = -1; n <= kBits + 1; ++n) {
+      for (size_t i = 0; i < len; ++i) {
+        dst1[i] = rotl_pure_c(src[i], n);
+      }
+      shlc_bulk(src.data(), dst2.data(), len, n);
+      validate(dst1, dst2, len);
+
+      dst2 = src;
+      shlc_bulk(dst2.data(), dst2.data(), len, n);
+      validate(dst1, dst2, len);
+    }
+  }
+}
+
+// Destinations at every offset from a cache line.
+static void test_unaligned(void)
+{
+  const size_t len = 1000;
+  std::vector<uint32_t> src(len + 16), dst1(len), dst2(len + 16);
+  neon_xoshiro128pp rng(1000);
+  rng.fill_bytes(src.data(), src.size() * sizeof(uint32_t));
+  for (size_t offset = 0; offset < 16; ++offset) {
+    for (size_t i = 0; i < len; ++i) {
+      dst1[i] = rotl_pure_c(src[i], 7);
+    }
+    shlc_bulk_u32(src.data(), dst2.data() + offset, len, 7);
+    validate(dst1, std::vector<uint32_t>(dst2.begin() + offset, dst2.end()), len);
+  }
+}
+
+static uint64_t stat(int width, int n, uint64_t shlc_bulk_stat::*field)
+{
+  for (const auto& s : shlc_bulk_stats_snapshot()) {
+    if (s.width == width && s.n == n) {
+      return s.*field;
+    }
+  }
+  return 0;
+}
+
+// Counts of calls from this thread and from one that has exited.
+static void test_stats(void)
+{
+  if (!shlc_bulk_stats_enabled()) {
+    return;
+  }
+  std::vector<uint32_t> buf(100);
+  const auto calls = stat(32, 5, &shlc_bulk_stat::calls);
+  const auto elems = stat(32, 5, &shlc_bulk_stat::elems);
+  shlc_bulk_u32(buf.data(), buf.data(), 100, 5);
+  std::thread([&buf]() {
+    shlc_bulk_u32(buf.data(), buf.data(), 50, 37);
+  }).join();
+  if (stat(32, 5, &shlc_bulk_stat::calls) != calls + 2 || stat(32, 5, &shlc_bulk_stat::elems) != elems + 150) {
+    printf("bulk stats: %" PRIu64 " calls, %" PRIu64 " elems\n",
+           stat(32, 5, &shlc_bulk_stat::calls) - calls, stat(32, 5, &shlc_bulk_stat::elems) - elems);
+  }
+}
+
+static bool same_config(const shlc_bulk_config& a, const shlc_bulk_config& b)
+{
+  return a.q == b.q && a.unroll == b.unroll && a.prefetch == b.prefetch && a.chunk == b.chunk &&
+         a.stream == b.stream && a.stream_prefetch == b.stream_prefetch && a.aligned == b.aligned;
+}
+
+// A tuning file named in the environment is in effect before the first
+// rotation, so that a bulk_state taken then saves it. This has to run before
+// anything else calls the bulk functions; it is skipped when the variable is
+// already set.
+static void test_tuning_env(void)
+{
+  if (getenv("NEON_CIRCULAR_SHIFT_TUNING")) {
+    return;
+  }
+  char path[] = "/tmp/neon_circular_shift_tuning_XXXXXX";
+  const int fd = mkstemp(path);
+  if (fd < 0) {
+    return;
+  }
+  close(fd);
+  FILE* f = fopen(path, "w");
+  if (!f) {
+    unlink(path);
+    return;
+  }
+  fprintf(f, "key %s\n16 1 4 192 0 0 1024 1\n", shlc_bulk_tuning_key().c_str());
+  fclose(f);
+  setenv("NEON_CIRCULAR_SHIFT_TUNING", path, 1);
+
+  const auto loaded = shlc_bulk_get_config(16);
+  if (loaded.unroll != 4 || loaded.prefetch != 192) {
+    printf("bulk: tuning file not in effect: unroll %d prefetch %zu\n", loaded.unroll, loaded.prefetch);
+  }
+  // A configuration set before the first rotation survives a save, a
+  // rotation and a restore.
+  auto c = loaded;
+  c.unroll = 2;
+  c.prefetch = 320;
+  shlc_bulk_set_config(16, c);
+  const bulk_state saved;
+  std::vector<uint16_t> buf(100);
+  shlc_bulk_u16(buf.data(), buf.data(), buf.size(), 3);
+  saved.restore();
+  if (!same_config(shlc_bulk_get_config(16), c)) {
+    printf("bulk: configuration lost across bulk_state\n");
+  }
+
+  unsetenv("NEON_CIRCULAR_SHIFT_TUNING");
+  unlink(path);
+  shlc_bulk_set_config(16, shlc_bulk_config());
+}
+
+void test_bulk(void)
+{
+  test_tuning_env();
+  const bulk_state saved;
+  for (const auto b : kBackends) {
+    if (!shlc_bulk_force_backend(b)) {
+      continue;
+    }
+    test_type<uint8_t>();
+    test_type<uint16_t>();
+    test_type<uint32_t>();
+    test_type<uint64_t>();
+    // sha3 only has u64; the narrower widths keep NEON.
+    if (shlc_bulk_backend(64) != b || (b == shlc_backend::sha3 && shlc_bulk_backend(32) != shlc_backend::neon)) {
+      printf("bulk: forced %s, got %s\n", shlc_backend_name(b), shlc_backend_name(shlc_bulk_backend(64)));
+    }
+  }
+  // Every variant of the neon backend, with a prefetch distance and a
+  // thread share small enough to split the longer buffers on some of them.
+  if (shlc_bulk_force_backend(shlc_backend::neon)) {
+    for (const auto q : { false, true }) {
+      for (const auto unroll : { 1, 2, 4, 8 }) {
+        shlc_bulk_config c;
+        c.q = q;
+        c.unroll = unroll;
+        c.prefetch = unroll == 2 ? 256 : 0;
+        c.chunk = unroll == 4 ? 1024 : 0;
+        for (const auto width : { 8, 16, 32, 64 }) {
+          shlc_bulk_set_config(width, c);
+        }
+        test_type<uint8_t>();
+        test_type<uint16_t>();
+        test_type<uint32_t>();
+        test_type<uint64_t>();
+      }
+    }
+  }
+  // The streaming kernels on every call, alone and split across threads.
+  for (const auto chunk : { 0, 1024 }) {
+    shlc_bulk_config c;
+    c.stream = 1;
+    c.stream_prefetch = 256;
+    c.chunk = chunk;
+    for (const auto width : { 8, 16, 32, 64 }) {
+      shlc_bulk_set_config(width, c);
+    }
+    test_type<uint8_t>();
+    test_type<uint16_t>();
+    test_type<uint32_t>();
+    test_type<uint64_t>();
+    test_unaligned();
+  }
+  saved.restore();
+  test_stats();
+}
+
+// Each backend at a generic shift count, at a multiple of 8 and at half the
+// width. The backend is forced when a case is prepared, and the cap from
+// before put back when it is done.
+template<typename T>
+static void perf_type(bench_registry* bench, const std::string& prefix)
+{
+  static const int kBits = 8 * sizeof(T);
+  const int ns[] = { 5, 8, kBits / 2 };
+  for (const auto b : kBackends) {
+    if (!shlc_bulk_supported(b)) {
+      continue;
+    }
+    for (const auto n : ns) {
+      auto c = bench_kernel<T>(prefix + "/bulk/" + shlc_backend_name(b), kBits, n, [n](const T* s, T* d, size_t len) {
+        shlc_bulk(s, d, len, n);
+      });
+      const auto prepare = c.prepare;
+      c.prepare = [prepare, b](size_t bytes) {
+        const bulk_state saved;
+        shlc_bulk_force_backend(b);
+        auto r = prepare(bytes);
+        r.teardown = [saved]() {
+          saved.restore();
+        };
+        return r;
+      };
+      bench->add(c);
+    }
+  }
+}
+
+// A table of lines the size of a mid-level cache, visited in a random cycle.
+static const std::vector<uint32_t>& neighbour_table()
+{
+  static const size_t kLines = (1 << 20) / 64;
+  static std::vector<uint32_t> table;
+  if (table.empty()) {
+    std::vector<uint32_t> order(kLines);
+    for (size_t i = 0; i < kLines; ++i) {
+      order[i] = static_cast<uint32_t>(i);
+    }
+    std::vector<uint32_t> r(kLines);
+    neon_xoshiro128pp rng(1000);
+    rng.fill_bytes(r.data(), kLines * sizeof(uint32_t));
+    for (size_t i = kLines - 1; i > 0; --i) {
+      std::swap(order[i], order[r[i] % i]);
+    }
+    table.resize(kLines * 16);
+    for (size_t i = 0; i < kLines; ++i) {
+      table[order[i] * 16] = order[(i + 1) % kLines];
+    }
+  }
+  return table;
+}
+
+// One round of the cycle: dependent loads that are fast while the table
+// stays in the cache.
+static void neighbour_chase(void)
+{
+  const auto& table = neighbour_table();
+  uint32_t i = 0;
+  for (size_t k = 0; k < table.size() / 16; ++k) {
+    i = table[i * 16];
+  }
+  bench_do_not_optimize(&i);
+}
+
+// The streaming kernels against the cached ones on buffers well past the
+// last-level cache, alone and followed by a cache-sensitive neighbour. The
+// cost of the rotation to the neighbour is the difference between the two
+// cases of a mode, less u32/bulk/neighbour alone.
+static void perf_stream(bench_registry* bench)
+{
+  const std::vector<size_t> sizes = { 64 << 20, 256 << 20 };
+  for (const auto stream : { true, false }) {
+    for (const auto neighbour : { false, true }) {
+      const auto name = std::string("u32/bulk/") + (stream ? "stream" : "cached") + (neighbour ? "+neighbour" : "");
+      auto c = bench_kernel<uint32_t>(name, 32, 5, [neighbour](const uint32_t* s, uint32_t* d, size_t len) {
+        shlc_bulk_u32(s, d, len, 5);
+        if (neighbour) {
+          neighbour_chase();
+        }
+      });
+      // The configuration in use, tuned or not, with streaming on or off.
+      const auto prepare = c.prepare;
+      c.prepare = [prepare, stream](size_t bytes) {
+        const bulk_state saved;
+        auto config = shlc_bulk_get_config(32);
+        config.stream = stream ? 1 : SIZE_MAX;
+        shlc_bulk_set_config(32, config);
+        auto r = prepare(bytes);
+        r.teardown = [saved]() {
+          saved.restore();
+        };
+        return r;
+      };
+      c.sizes = sizes;
+      bench->add(c);
+    }
+  }
+  bench_case c;
+  c.name = "u32/bulk/neighbour";
+  c.prepare = [](size_t) {
+    neighbour_chase();
+    bench_run r;
+    r.run = neighbour_chase;
+    r.elems = neighbour_table().size() / 16;
+    r.bytes = neighbour_table().size() * sizeof(uint32_t);
+    r.traffic = bench_traffic::read;
+    return r;
+  };
+  c.sizes = { neighbour_table().size() * sizeof(uint32_t) };
+  bench->add(c);
+}
+
+void perf_bulk(bench_registry* bench)
+{
+  perf_type<uint32_t>(bench, "u32");
+  perf_type<uint64_t>(bench, "u64");
+  perf_stream(bench);
+}
@@ -0,0 +1,31 @@
+#ifndef TEST_BULK_STATE_H
+#define TEST_BULK_STATE_H
+
+#include "neon_circular_shift_bulk.h"
+
+// The backend cap and the configuration of every width of the bulk
+// rotations, e.g. from a tuning file, for a test or a benchmark case that
+// changes them to put back.
+class bulk_state {
+public:
+  bulk_state() : cap_(shlc_bulk_forced_backend())
+  {
+    for (int i = 0; i < 4; ++i) {
+      configs_[i] = shlc_bulk_get_config(8 << i);
+    }
+  }
+
+  void restore() const
+  {
+    for (int i = 0; i < 4; ++i) {
+      shlc_bulk_set_config(8 << i, configs_[i]);
+    }
+    shlc_bulk_force_backend(cap_);
+  }
+
+private:
+  shlc_backend cap_;
+  shlc_bulk_config configs_[4];
+};
+
+#endif /* TEST_BULK_STATE_H */
@@ -0,0 +1,148 @@
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+
+#include <arm_neon.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "neon_buzhash.h"
+#include "neon_xoshiro.h"
+#include "test_common.h"
+
+static uint32_t rotl_pure_c(uint32_t v, int n)
+{
+  n &= 31;
+  return n ? (v << n) | (v >> (32 - n)) : v;
+}
+
+// Byte-at-a-time chunker with the same table, mask and cut rules.
+static std::vector<uint64_t> chunk_pure_c(const std::vector<uint8_t>& src, size_t min_size, size_t max_size,
+                                          size_t window, uint64_t seed, uint32_t mask)
+{
+  uint32_t table[256];
+  neon_xoshiro128pp rng(seed);
+  rng.fill(table, 256);
+
+  std::vector<uint8_t> buf(window, 0);
+  buf.insert(buf.end(), src.begin(), src.end());
+  uint32_t h = 0;
+  for (size_t j = 0; j < window; ++j) {
+    h ^= rotl_pure_c(table[0], static_cast<int>(j));
+  }
+
+  std::vector<uint64_t> cuts;
+  uint64_t last = 0;
+  for (size_t i = 0; i < src.size(); ++i) {
+    h = rotl_pure_c(h, 1) ^ rotl_pure_c(table[buf[i]], static_cast<int>(window)) ^ table[buf[i + window]];
+    const auto len = i + 1 - last;
+    if (len >= max_size || (len >= min_size && (h & mask) == 0)) {
+      last = i + 1;
+      cuts.push_back(last);
+    }
+  }
+  if (last < src.size()) {
+    cuts.push_back(src.size());
+  }
+  return cuts;
+}
+
+static void test_chunker(const std::vector<uint8_t>& src, size_t min_size, size_t avg_size, size_t max_size,
+                         size_t window)
+{
+  neon_buzhash_chunker chunker(min_size, avg_size, max_size, window, 7);
+  const auto expected = chunk_pure_c(src, min_size, max_size, window, 7, chunker.mask());
+
+  std::vector<uint64_t> cuts;
+  chunker.update(src.data(), src.size(), &cuts);
+  chunker.finish(&cuts);
+  if (cuts.size() != expected.size()) {
+    printf("test_buzhash: %zu cuts, expected %zu\n", cuts.size(), expected.size());
+    return;
+  }
+  validate(expected, cuts, expected.size());
+
+  // Feeds of random sizes, including ones shorter than the window.
+  chunker.reset();
+  cuts.clear();
+  neon_xoshiro128pp rng(5);
+  for (size_t i = 0; i < src.size();) {
+    uint32_t r;
+    rng.fill(&r, 1);
+    auto n = (r & 1) ? r % 17 : r % 20000;
+    if (n > src.size() - i) {
+      n = src.size() - i;
+    }
+    chunker.update(src.data() + i, n, &cuts);
+    i += n;
+  }
+  chunker.finish(&cuts);
+  if (cuts.size() != expected.size()) {
+    printf("test_buzhash: %zu cuts in feeds, expected %zu\n", cuts.size(), expected.size());
+    return;
+  }
+  validate(expected, cuts, expected.size());
+}
+
+void test_buzhash(void)
+{
+  static const size_t kBufLen = 1024*1024 + 13;
+  std::vector<uint8_t> src(kBufLen);
+  neon_xoshiro128pp rng(1000);
+  rng.fill_bytes(src.data(), kBufLen);
+
+  test_chunker(src, 2048, 8192, 65536, 48);
+  test_chunker(src, 256, 1024, 4096, 32);
+  test_chunker(src, 64, 128, 200, 31);
+  // Low-entropy input hits the max_size cut.
+  std::vector<uint8_t> zeros(kBufLen, 0);
+  test_chunker(zeros, 2048, 8192, 65536, 48);
+}
+
+static void perf_chunker(bench_registry* bench, const std::string& name, bool neon)
+{
+  bench_case c;
+  c.name = name;
+  c.width = 8;
+  c.prepare = [neon](size_t bytes) {
+    auto src = std::make_shared<std::vector<uint8_t>>(std::max<size_t>(bytes, 1));
+    neon_xoshiro128pp rng(1000);
+    rng.fill_bytes(src->data(), src->size());
+    auto chunker = std::make_shared<neon_buzhash_chunker>(2048, 8192, 65536);
+    auto cuts = std::make_shared<std::vector<uint64_t>>();
+    bench_run r;
+    if (neon) {
+      r.run = [src, chunker, cuts]() {
+        // 1 MB feeds, as when reading a large file.
+        static const size_t kFeed = 1024*1024;
+        chunker->reset();
+        cuts->clear();
+        for (size_t i = 0; i < src->size(); i += kFeed) {
+          chunker->update(src->data() + i, std::min(kFeed, src->size() - i), cuts.get());
+        }
+        chunker->finish(cuts.get());
+      };
+    } else {
+      r.run = [src, chunker, cuts]() {
+        *cuts = chunk_pure_c(*src, 2048, 65536, 48, 0, chunker->mask());
+      };
+    }
+    r.run();
+    r.elems = src->size();
+    r.bytes = src->size();
+    r.traffic = bench_traffic::read;
+    r.counters.push_back({ "chunks", static_cast<double>(cuts->size()) });
+    return r;
+  };
+  bench->add(c);
+}
+
+void perf_buzhash(bench_registry* bench)
+{
+  perf_chunker(bench, "buzhash/pure_c", false);
+  perf_chunker(bench, "buzhash/neon", true);
+}
@@ -0,0 +1,246 @@
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+#include <cstring>
+
+#include <arm_neon.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <thread>
+
+#include "bench.h"
+#include "neon_counter_rng.h"
+#include "test_common.h"
+
+static uint64_t rotl64(uint64_t x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+static uint32_t rotl32(uint32_t x, int k)
+{
+  return (x << k) | (x >> (32 - k));
+}
+
+static void threefry2x64_pure_c(const uint64_t* ctr, const uint64_t* key, uint64_t* out)
+{
+  static const int R[8] = { 16, 42, 12, 31, 16, 32, 24, 21 };
+  const uint64_t ks[3] = { key[0], key[1], 0x1BD11BDAA9FC1A22ULL ^ key[0] ^ key[1] };
+  uint64_t x0 = ctr[0] + ks[0];
+  uint64_t x1 = ctr[1] + ks[1];
+  for (int r = 0; r < 20; ++r) {
+    x0 += x1;
+    x1 = rotl64(x1, R[r % 8]);
+    x1 ^= x0;
+    if (r % 4 == 3) {
+      const int s = (r + 1) / 4;
+      x0 += ks[s % 3];
+      x1 += ks[(s + 1) % 3] + s;
+    }
+  }
+  out[0] = x0;
+  out[1] = x1;
+}
+
+static void threefry4x32_pure_c(const uint32_t* ctr, const uint32_t* key, uint32_t* out)
+{
+  static const int R[8][2] = {
+    { 10, 26 }, { 11, 21 }, { 13, 27 }, { 23, 5 }, { 6, 20 }, { 17, 11 }, { 25, 10 }, { 18, 20 }
+  };
+  const uint32_t ks[5] = { key[0], key[1], key[2], key[3], 0x1BD11BDA ^ key[0] ^ key[1] ^ key[2] ^ key[3] };
+  uint32_t x[4];
+  for (int i = 0; i < 4; ++i) {
+    x[i] = ctr[i] + ks[i];
+  }
+  for (int r = 0; r < 20; ++r) {
+    if (r % 2 == 0) {
+      x[0] += x[1]; x[1] = rotl32(x[1], R[r % 8][0]); x[1] ^= x[0];
+      x[2] += x[3]; x[3] = rotl32(x[3], R[r % 8][1]); x[3] ^= x[2];
+    } else {
+      x[0] += x[3]; x[3] = rotl32(x[3], R[r % 8][0]); x[3] ^= x[0];
+      x[2] += x[1]; x[1] = rotl32(x[1], R[r % 8][1]); x[1] ^= x[2];
+    }
+    if (r % 4 == 3) {
+      const int s = (r + 1) / 4;
+      for (int i = 0; i < 4; ++i) {
+        x[i] += ks[(s + i) % 5];
+      }
+      x[3] += s;
+    }
+  }
+  memcpy(out, x, sizeof(x));
+}
+
+static void philox4x32_pure_c(const uint32_t* ctr, const uint32_t* key, uint32_t* out)
+{
+  uint32_t x[4] = { ctr[0], ctr[1], ctr[2], ctr[3] };
+  uint32_t k0 = key[0], k1 = key[1];
+  for (int r = 0; r < 10; ++r) {
+    const uint64_t p0 = static_cast<uint64_t>(0xD2511F53) * x[0];
+    const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57) * x[2];
+    const uint32_t y[4] = {
+      static_cast<uint32_t>(p1 >> 32) ^ x[1] ^ k0, static_cast<uint32_t>(p1),
+      static_cast<uint32_t>(p0 >> 32) ^ x[3] ^ k1, static_cast<uint32_t>(p0)
+    };
+    memcpy(x, y, sizeof(x));
+    k0 += 0x9E3779B9;
+    k1 += 0xBB67AE85;
+  }
+  memcpy(out, x, sizeof(x));
+}
+
+// Random123 kat_vectors: zero, all-ones and pi-digit counters/keys.
+static void test_kat(void)
+{
+  static const uint64_t tf2x64[3][6] = {
+    { 0, 0, 0, 0, 0xc2b6e3a8c2c69865ULL, 0x6f81ed42f350084dULL },
+    { ~0ULL, ~0ULL, ~0ULL, ~0ULL, 0xe02cb7c4d95d277aULL, 0xd06633d0893b8b68ULL },
+    { 0x243f6a8885a308d3ULL, 0x13198a2e03707344ULL, 0xa4093822299f31d0ULL, 0x082efa98ec4e6c89ULL,
+      0x263c7d30bb0f0af1ULL, 0x56be8361d3311526ULL },
+  };
+  static const uint32_t tf4x32[3][12] = {
+    { 0, 0, 0, 0, 0, 0, 0, 0, 0x9c6ca96a, 0xe17eae66, 0xfc10ecd4, 0x5256a7d8 },
+    { ~0U, ~0U, ~0U, ~0U, ~0U, ~0U, ~0U, ~0U, 0x2a881696, 0x57012287, 0xf6c7446e, 0xa16a6732 },
+    { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344, 0xa4093822, 0x299f31d0, 0x082efa98, 0xec4e6c89,
+      0x59cd1dbb, 0xb8879579, 0x86b5d00c, 0xac8b6d84 },
+  };
+  static const uint32_t ph4x32[3][10] = {
+    { 0, 0, 0, 0, 0, 0, 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 },
+    { ~0U, ~0U, ~0U, ~0U, ~0U, ~0U, 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd },
+    { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344, 0xa4093822, 0x299f31d0,
+      0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 },
+  };
+
+  for (int i = 0; i < 3; ++i) {
+    std::vector<uint64_t> expected(tf2x64[i] + 4, tf2x64[i] + 6), ref(2), out(2);
+    threefry2x64_pure_c(tf2x64[i], tf2x64[i] + 2, ref.data());
+    neon_threefry2x64(tf2x64[i][2], tf2x64[i][3]).block(tf2x64[i], out.data());
+    validate(expected, ref, 2);
+    validate(expected, out, 2);
+  }
+  for (int i = 0; i < 3; ++i) {
+    std::vector<uint32_t> expected(tf4x32[i] + 8, tf4x32[i] + 12), ref(4), out(4);
+    threefry4x32_pure_c(tf4x32[i], tf4x32[i] + 4, ref.data());
+    neon_threefry4x32(tf4x32[i] + 4).block(tf4x32[i], out.data());
+    validate(expected, ref, 4);
+    validate(expected, out, 4);
+  }
+  for (int i = 0; i < 3; ++i) {
+    std::vector<uint32_t> expected(ph4x32[i] + 6, ph4x32[i] + 10), ref(4), out(4);
+    philox4x32_pure_c(ph4x32[i], ph4x32[i] + 4, ref.data());
+    neon_philox4x32(ph4x32[i] + 4).block(ph4x32[i], out.data());
+    validate(expected, ref, 4);
+    validate(expected, out, 4);
+  }
+}
+
+template<typename T, int kWords>
+static void ref_generate(void (*ref_func)(const T*, const T*, T*), const T* key,
+                         uint64_t counter_start, std::vector<T>* dst, size_t buf_len)
+{
+  auto d = dst->data();
+  for (size_t i = 0; i < buf_len; i += kWords) {
+    const uint64_t c = counter_start + i / kWords;
+    T ctr[kWords] = {};
+    ctr[0] = static_cast<T>(c);
+    if (sizeof(T) == 4) {
+      ctr[1] = static_cast<T>(c >> 32);
+    }
+    T out[kWords];
+    ref_func(ctr, key, out);
+    memcpy(d + i, out, std::min<size_t>(kWords, buf_len - i) * sizeof(T));
+  }
+}
+
+template<typename Gen, typename F>
+static void test_gen(const Gen& gen, void (*ref_func)(const typename Gen::value_type*,
+                                                      const typename Gen::value_type*,
+                                                      typename Gen::value_type*),
+                     const typename Gen::value_type* key, size_t buf_len)
+{
+  typedef typename Gen::value_type T;
+  // Crosses the 32-bit boundary of the block counter.
+  const uint64_t kCounter = 0xfffffff0ULL;
+  std::vector<T> dst1(buf_len), dst2(buf_len), dst3(buf_len);
+
+  ref_generate<T, Gen::kWords>(ref_func, key, kCounter, &dst1, buf_len);
+  gen.generate(kCounter, dst2.data(), buf_len);
+  validate(dst1, dst2, buf_len);
+
+  // O(1) jump: the stream seen from block 100 on is the tail of the stream above.
+  const size_t kSkip = 100;
+  std::vector<T> tail(dst1.begin() + kSkip * Gen::kWords, dst1.end());
+  gen.generate(kCounter + kSkip, dst3.data(), buf_len - kSkip * Gen::kWords);
+  validate(tail, dst3, tail.size());
+
+  for (const auto threads : { 4, 1, 0 }) {
+    std::fill(dst3.begin(), dst3.end(), 0);
+    neon_counter_rng_generate_parallel(gen, kCounter, dst3.data(), buf_len, threads);
+    validate(dst1, dst3, buf_len);
+  }
+
+  std::vector<F> uniform(buf_len);
+  gen.generate_uniform(kCounter, uniform.data(), buf_len);
+  size_t out_of_range = 0;
+  for (size_t i = 0; i < buf_len; ++i) {
+    const F expected = static_cast<F>(dst1[i] >> (sizeof(T) * 8 - (sizeof(F) == 4 ? 24 : 53))) /
+      static_cast<F>(sizeof(F) == 4 ? 16777216.0 : 9007199254740992.0);
+    if (uniform[i] < 0 || uniform[i] >= 1 || uniform[i] != expected) {
+      ++out_of_range;
+    }
+  }
+  if (out_of_range) {
+    printf("%s: %zu bad uniform values\n", __FUNCTION__, out_of_range);
+  }
+}
+
+void test_counter_rng(void)
+{
+  static const size_t kBufLen = 64*1024;
+  static const uint64_t key64[2] = { 0x0123456789abcdefULL, 42 };
+  static const uint32_t key32[4] = { 0x01234567, 0x89abcdef, 42, 7 };
+
+  test_kat();
+
+  test_gen<neon_threefry2x64, double>(neon_threefry2x64(key64[0], key64[1]), threefry2x64_pure_c, key64, kBufLen);
+  test_gen<neon_threefry2x64, double>(neon_threefry2x64(key64[0], key64[1]), threefry2x64_pure_c, key64, kBufLen - 1);
+  test_gen<neon_threefry4x32, float>(neon_threefry4x32(key32), threefry4x32_pure_c, key32, kBufLen);
+  test_gen<neon_threefry4x32, float>(neon_threefry4x32(key32), threefry4x32_pure_c, key32, kBufLen - 5);
+  test_gen<neon_philox4x32, float>(neon_philox4x32(key32), philox4x32_pure_c, key32, kBufLen);
+  test_gen<neon_philox4x32, float>(neon_philox4x32(key32), philox4x32_pure_c, key32, kBufLen - 5);
+}
+
+template<typename Gen>
+static void perf_gen(bench_registry* bench, const std::string& name, const Gen& gen, int threads)
+{
+  typedef typename Gen::value_type T;
+  bench->add(bench_buffer<T>("counter_rng/" + name + "/x" + std::to_string(threads), 8 * sizeof(T), -1,
+                             [gen, threads](T* dst, size_t len) {
+    if (threads > 1) {
+      neon_counter_rng_generate_parallel(gen, 0, dst, len, threads);
+    } else {
+      gen.generate(0, dst, len);
+    }
+  }));
+}
+
+void perf_counter_rng(bench_registry* bench)
+{
+  static const uint32_t key32[4] = { 0x01234567, 0x89abcdef, 42, 7 };
+  const int threads = std::max(1u, std::thread::hardware_concurrency());
+
+  const neon_threefry2x64 tf2x64(0x0123456789abcdefULL, 42);
+  const neon_threefry4x32 tf4x32(key32);
+  const neon_philox4x32 ph4x32(key32);
+
+  for (const auto t : { 1, threads }) {
+    perf_gen(bench, "threefry2x64", tf2x64, t);
+    perf_gen(bench, "threefry4x32", tf4x32, t);
+    perf_gen(bench, "philox4x32", ph4x32, t);
+    if (threads == 1) {
+      break;
+    }
+  }
+}
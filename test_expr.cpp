@@ -0,0 +1,99 @@
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+#include <cstring>
+
+#include <arm_neon.h>
+
+#include <vector>
+
+#include "bench.h"
+#include "neon_circular_shift_expr.h"
+#include "neon_xoshiro.h"
+
+template<typename T>
+static T rotl_pure_c(T v, int n)
+{
+  static const int kBits = 8 * sizeof(T);
+  n = ((n % kBits) + kBits) % kBits;
+  return n == 0 ? v : static_cast<T>((v << n) | (v >> (kBits - n)));
+}
+
+template<typename T, typename V>
+static void check(V got, V v, int n, int line)
+{
+  static const size_t kLanes = sizeof(V) / sizeof(T);
+  T g[kLanes], s[kLanes];
+  memcpy(g, &got, sizeof(V));
+  memcpy(s, &v, sizeof(V));
+  for (size_t i = 0; i < kLanes; ++i) {
+    if (g[i] != rotl_pure_c(s[i], n)) {
+      printf("expr: line %d: u%zu n=%d lane %zu: %" PRIu64 " != %" PRIu64 "\n", line, 8 * sizeof(T), n, i,
+             static_cast<uint64_t>(g[i]), static_cast<uint64_t>(rotl_pure_c(s[i], n)));
+      return;
+    }
+  }
+}
+
+#define CHECK(T, V, got, v, n) check<T, V>(got, v, n, __LINE__)
+
+template<typename T, typename V>
+static void test_type(void)
+{
+  static const int kBits = 8 * sizeof(T);
+  V v;
+  neon_xoshiro128pp rng(1000 + sizeof(V) + kBits);
+  rng.fill_bytes(&v, sizeof(v));
+
+  CHECK(T, V, vshlc_lazy(v).template rotl<5>().template rotr<9>().template rotl<4>(), v, 0);
+  CHECK(T, V, vshlc_lazy(v).template rotl<3>().template rotl<kBits - 2>(), v, 1);
+  CHECK(T, V, vshlc_lazy(v).template rotl<kBits / 2>(), v, kBits / 2);
+  CHECK(T, V, vshlc_lazy(v).template rotl<8 + kBits>(), v, 8);
+  CHECK(T, V, vshlc_lazy(v).template rotr<-3 * kBits - 1>(), v, 1);
+  CHECK(T, V, (vshlc_fold<5, 13, 7>(v)), v, 25);
+  CHECK(T, V, (vshlc_fold<-1, 2 * kBits>(v)), v, -1);
+  static_assert(decltype(vshlc_lazy(v).template rotl<5>().template rotl<kBits - 5>())::count() == 0,
+                "a full turn folds to nothing");
+
+  for (int k = -2 * kBits; k <= 2 * kBits; ++k) {
+    CHECK(T, V, vshlc_lazy(v).template rotl<5>().rotl(k), v, 5 + k);
+    CHECK(T, V, vshlc_lazy(v).rotr(k).template rotl<7>().template rotr<kBits + 1>(), v, 6 - k);
+    CHECK(T, V, vshlc_lazy(v).rotl(k).rotl(3 * k), v, 4 * k);
+    CHECK(T, V, vshlc_fn<V>(k)(v), v, k);
+  }
+}
+
+void test_expr(void)
+{
+  test_type<uint8_t, uint8x8_t>();
+  test_type<uint16_t, uint16x4_t>();
+  test_type<uint32_t, uint32x2_t>();
+  test_type<uint64_t, uint64x1_t>();
+  test_type<uint8_t, uint8x16_t>();
+  test_type<uint16_t, uint16x8_t>();
+  test_type<uint32_t, uint32x4_t>();
+  test_type<uint64_t, uint64x2_t>();
+}
+
+// rotl 5, 13 and 7 in a row (25 in all), applied one by one, folded at
+// compile time, and folded at run time from counts the compiler cannot see.
+void perf_expr(bench_registry* bench)
+{
+  bench->add(bench_kernel<uint32_t>("u32/q/chain3", 32, 25, [](const uint32_t* s, uint32_t* d, size_t len) {
+    for (size_t i = 0; i < len; i += 4) {
+      vst1q_u32(d + i, vshlcq_n_u32<7>(vshlcq_n_u32<13>(vshlcq_n_u32<5>(vld1q_u32(s + i)))));
+    }
+  }));
+  bench->add(bench_kernel<uint32_t>("u32/q/chain3_folded", 32, 25, [](const uint32_t* s, uint32_t* d, size_t len) {
+    for (size_t i = 0; i < len; i += 4) {
+      vst1q_u32(d + i, vshlc_fold<5, 13, 7>(vld1q_u32(s + i)));
+    }
+  }));
+  bench->add(bench_kernel<uint32_t>("u32/q/chain3_rt", 32, 25, [](const uint32_t* s, uint32_t* d, size_t len) {
+    static volatile int counts[] = { 5, 13, 7 };
+    const auto rotl = vshlc_fn<uint32x4_t>(counts[0] + counts[1] + counts[2]);
+    for (size_t i = 0; i < len; i += 4) {
+      vst1q_u32(d + i, rotl(vld1q_u32(s + i)));
+    }
+  }));
+}
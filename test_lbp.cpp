@@ -0,0 +1,135 @@
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+
+#include <arm_neon.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "neon_lbp.h"
+#include "neon_xoshiro.h"
+#include "test_common.h"
+
+static uint8_t rotl8_pure_c(uint8_t v, int n)
+{
+  return static_cast<uint8_t>((v << n) | (v >> ((8 - n) & 7)));
+}
+
+static int popcount8_pure_c(uint8_t v)
+{
+  int n = 0;
+  for (int i = 0; i < 8; ++i) {
+    n += (v >> i) & 1;
+  }
+  return n;
+}
+
+static void lbp_pure_c(const std::vector<uint8_t>& src, size_t width, size_t height,
+                       std::vector<uint8_t>* dst, neon_lbp_mapping mapping)
+{
+  static const int dx[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+  static const int dy[8] = { 0, -1, -1, -1, 0, 1, 1, 1 };
+  for (size_t y = 1; y + 1 < height; ++y) {
+    for (size_t x = 1; x + 1 < width; ++x) {
+      const auto c = src[y * width + x];
+      uint8_t code = 0;
+      for (int p = 0; p < 8; ++p) {
+        if (src[(y + dy[p]) * width + x + dx[p]] >= c) {
+          code |= static_cast<uint8_t>(1 << p);
+        }
+      }
+      auto v = code;
+      if (mapping == neon_lbp_mapping::ri) {
+        for (int r = 1; r < 8; ++r) {
+          if (rotl8_pure_c(code, r) < v) {
+            v = rotl8_pure_c(code, r);
+          }
+        }
+      } else if (mapping == neon_lbp_mapping::riu2) {
+        v = popcount8_pure_c(code ^ rotl8_pure_c(code, 1)) <= 2 ? static_cast<uint8_t>(popcount8_pure_c(code)) : 9;
+      }
+      (*dst)[(y - 1) * (width - 2) + x - 1] = v;
+    }
+  }
+}
+
+static void test_image(size_t width, size_t height, neon_lbp_mapping mapping)
+{
+  std::vector<uint8_t> src(width * height);
+  neon_xoshiro128pp rng(1000);
+  rng.fill_bytes(src.data(), src.size());
+  // Few grey levels so that equal neighbours are common.
+  for (auto& v : src) {
+    v &= 0x3;
+  }
+  const auto len = (width - 2) * (height - 2);
+  std::vector<uint8_t> dst1(len), dst2(len);
+
+  lbp_pure_c(src, width, height, &dst1, mapping);
+  neon_lbp(src.data(), width, height, width, dst2.data(), width - 2, mapping);
+  validate(dst1, dst2, len);
+}
+
+void test_lbp(void)
+{
+  static const neon_lbp_mapping mappings[] = {
+    neon_lbp_mapping::none, neon_lbp_mapping::ri, neon_lbp_mapping::riu2
+  };
+  for (const auto m : mappings) {
+    test_image(3, 3, m);
+    test_image(11, 7, m);
+    test_image(18, 5, m);
+    test_image(19, 5, m);
+    test_image(67, 33, m);
+    test_image(640, 480, m);
+  }
+}
+
+// 1920 pixel wide frames of as many rows as fit in half the working set.
+static void perf_mapping(bench_registry* bench, const std::string& name, neon_lbp_mapping mapping, bool neon)
+{
+  bench_case c;
+  c.name = name;
+  c.width = 8;
+  c.prepare = [mapping, neon](size_t bytes) {
+    static const size_t kWidth = 1920;
+    const auto height = std::max<size_t>(bytes / (2 * kWidth), 3);
+    auto src = std::make_shared<std::vector<uint8_t>>(kWidth * height);
+    neon_xoshiro128pp rng(1000);
+    rng.fill_bytes(src->data(), src->size());
+    auto dst = std::make_shared<std::vector<uint8_t>>((kWidth - 2) * (height - 2));
+    bench_run r;
+    if (neon) {
+      r.run = [src, dst, height, mapping]() {
+        neon_lbp(src->data(), kWidth, height, kWidth, dst->data(), kWidth - 2, mapping);
+        bench_do_not_optimize(dst->data());
+      };
+    } else {
+      r.run = [src, dst, height, mapping]() {
+        lbp_pure_c(*src, kWidth, height, dst.get(), mapping);
+        bench_do_not_optimize(dst->data());
+      };
+    }
+    r.elems = dst->size();
+    r.bytes = src->size() + dst->size();
+    return r;
+  };
+  bench->add(c);
+}
+
+void perf_lbp(bench_registry* bench)
+{
+  static const struct { neon_lbp_mapping mapping; const char* name; } mappings[] = {
+    { neon_lbp_mapping::none, "none" },
+    { neon_lbp_mapping::ri, "ri" },
+    { neon_lbp_mapping::riu2, "riu2" },
+  };
+  for (const auto& m : mappings) {
+    perf_mapping(bench, std::string("lbp/") + m.name + "/pure_c", m.mapping, false);
+    perf_mapping(bench, std::string("lbp/") + m.name + "/neon", m.mapping, true);
+  }
+}
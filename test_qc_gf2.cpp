@@ -0,0 +1,175 @@
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+
+#include <arm_neon.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "neon_qc_gf2.h"
+#include "neon_xoshiro.h"
+#include "test_common.h"
+
+struct qc_block {
+  std::vector<uint32_t> positions;
+};
+
+static int get_bit(const uint32_t* v, size_t i)
+{
+  return (v[i / 32] >> (i % 32)) & 1;
+}
+
+// y_r = XOR over c and t of x_c rotated by t, bit by bit.
+static void qc_mul_pure_c(const std::vector<qc_block>& blocks, size_t rows, size_t cols, size_t p,
+                          const std::vector<uint32_t>& x, std::vector<uint32_t>* y)
+{
+  const auto words = (p + 31) / 32;
+  y->assign(rows * words, 0);
+  for (size_t r = 0; r < rows; ++r) {
+    for (size_t i = 0; i < p; ++i) {
+      int bit = 0;
+      for (size_t c = 0; c < cols; ++c) {
+        for (const auto t : blocks[r * cols + c].positions) {
+          bit ^= get_bit(x.data() + c * words, (i + p - t) % p);
+        }
+      }
+      (*y)[r * words + i / 32] |= static_cast<uint32_t>(bit) << (i % 32);
+    }
+  }
+}
+
+// Word-at-a-time baseline: funnel-shift the extended block for every position.
+static void qc_mul_words_pure_c(const std::vector<qc_block>& blocks, size_t rows, size_t cols, size_t p,
+                                const std::vector<uint32_t>& x, std::vector<uint32_t>* y)
+{
+  const auto words = (p + 31) / 32;
+  std::vector<uint32_t> ext(3 * words + 2);
+  y->assign(rows * words, 0);
+  for (size_t c = 0; c < cols; ++c) {
+    std::fill(ext.begin(), ext.end(), 0);
+    for (size_t k = 0; k < 32 * ext.size(); ++k) {
+      ext[k / 32] |= static_cast<uint32_t>(get_bit(x.data() + c * words, k % p)) << (k % 32);
+    }
+    for (size_t r = 0; r < rows; ++r) {
+      for (const auto t : blocks[r * cols + c].positions) {
+        const auto o = (p - t) % p;
+        const auto q = o / 32;
+        const auto b = o % 32;
+        for (size_t j = 0; j < words; ++j) {
+          (*y)[r * words + j] ^= b ? (ext[q + j] >> b) | (ext[q + j + 1] << (32 - b)) : ext[q + j];
+        }
+      }
+    }
+  }
+  if (p % 32) {
+    for (size_t r = 0; r < rows; ++r) {
+      (*y)[r * words + words - 1] &= (1U << (p % 32)) - 1;
+    }
+  }
+}
+
+// Blocks alternate between sparse ones of weight 1 .. 5, dense ones and zero ones.
+static void make_matrix(size_t rows, size_t cols, size_t p, uint64_t seed, bool dense_only,
+                        std::vector<qc_block>* blocks, neon_qc_gf2_matrix* m)
+{
+  const auto words = (p + 31) / 32;
+  neon_xoshiro128pp rng(seed);
+  blocks->assign(rows * cols, qc_block());
+  for (size_t i = 0; i < rows * cols; ++i) {
+    auto& block = (*blocks)[i];
+    if (dense_only || i % 3 == 1) {
+      std::vector<uint32_t> column(words);
+      rng.fill(column.data(), words);
+      for (size_t t = 0; t < p; ++t) {
+        if (get_bit(column.data(), t)) {
+          block.positions.push_back(static_cast<uint32_t>(t));
+        }
+      }
+      m->set_dense(i / cols, i % cols, column.data());
+    } else if (i % 3 == 0) {
+      const auto weight = 1 + i % 5;
+      for (size_t k = 0; k < weight; ++k) {
+        uint32_t t;
+        rng.fill(&t, 1);
+        block.positions.push_back(t % static_cast<uint32_t>(p));
+      }
+      m->set_sparse(i / cols, i % cols, block.positions.data(), weight);
+    }
+  }
+}
+
+static void test_matrix(size_t rows, size_t cols, size_t p)
+{
+  std::vector<qc_block> blocks;
+  neon_qc_gf2_matrix m(rows, cols, p);
+  make_matrix(rows, cols, p, 1000 + p, false, &blocks, &m);
+
+  const auto words = m.block_words();
+  std::vector<uint32_t> x(cols * words), y1, y2(rows * words);
+  neon_xoshiro128pp rng(p);
+  rng.fill(x.data(), x.size());
+  // Bits past p are ignored.
+  qc_mul_pure_c(blocks, rows, cols, p, x, &y1);
+  m.multiply(x.data(), y2.data());
+  validate(y1, y2, y1.size());
+}
+
+void test_qc_gf2(void)
+{
+  static const size_t sizes[] = { 1, 31, 32, 33, 100, 128, 384, 1021 };
+  for (const auto p : sizes) {
+    test_matrix(1, 1, p);
+    test_matrix(2, 3, p);
+  }
+}
+
+// The shape is fixed by the code; the one size is the message in bytes.
+static void perf_encode(bench_registry* bench, const std::string& name, size_t rows, size_t cols, size_t p,
+                        bool dense, bool neon)
+{
+  bench_case c;
+  c.name = name;
+  c.width = 1;
+  c.sizes = { cols * p / 8 };
+  c.prepare = [rows, cols, p, dense, neon](size_t) {
+    auto blocks = std::make_shared<std::vector<qc_block>>();
+    auto m = std::make_shared<neon_qc_gf2_matrix>(rows, cols, p);
+    make_matrix(rows, cols, p, 1000, dense, blocks.get(), m.get());
+
+    const auto words = m->block_words();
+    auto x = std::make_shared<std::vector<uint32_t>>(cols * words);
+    auto y = std::make_shared<std::vector<uint32_t>>(rows * words);
+    neon_xoshiro128pp rng(1000);
+    rng.fill(x->data(), x->size());
+    bench_run r;
+    if (neon) {
+      r.run = [m, x, y]() {
+        m->multiply(x->data(), y->data());
+        bench_do_not_optimize(y->data());
+      };
+    } else {
+      r.run = [blocks, rows, cols, p, x, y]() {
+        qc_mul_words_pure_c(*blocks, rows, cols, p, *x, y.get());
+        bench_do_not_optimize(y->data());
+      };
+    }
+    // Message bits encoded per call.
+    r.elems = cols * p;
+    r.bytes = (cols + rows) * p / 8;
+    return r;
+  };
+  bench->add(c);
+}
+
+void perf_qc_gf2(bench_registry* bench)
+{
+  // Parity of a QC-LDPC-like code with Z = 384 circulants.
+  perf_encode(bench, "qc_gf2/ldpc_12x24_384/pure_c", 12, 24, 384, false, false);
+  perf_encode(bench, "qc_gf2/ldpc_12x24_384/neon", 12, 24, 384, false, true);
+  // Product with a dense BIKE-1 (level 1) sized circulant.
+  perf_encode(bench, "qc_gf2/mdpc_1x1_12323/pure_c", 1, 1, 12323, true, false);
+  perf_encode(bench, "qc_gf2/mdpc_1x1_12323/neon", 1, 1, 12323, true, true);
+}
@@ -0,0 +1,116 @@
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+#include <cstring>
+
+#include <arm_neon.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "bench.h"
+#include "neon_roll.h"
+#include "neon_xoshiro.h"
+#include "test_common.h"
+
+static size_t wrap_pure_c(ptrdiff_t shift, size_t n)
+{
+  auto s = shift % static_cast<ptrdiff_t>(n);
+  return static_cast<size_t>(s < 0 ? s + static_cast<ptrdiff_t>(n) : s);
+}
+
+template<typename T>
+static void roll_2d_pure_c(const std::vector<T>& src, std::vector<T>* dst, size_t stride,
+                           size_t width, size_t height, ptrdiff_t dx, ptrdiff_t dy)
+{
+  for (size_t y = 0; y < height; ++y) {
+    for (size_t x = 0; x < width; ++x) {
+      const auto ty = (y + wrap_pure_c(dy, height)) % height;
+      const auto tx = (x + wrap_pure_c(dx, width)) % width;
+      (*dst)[ty * stride + tx] = src[y * stride + x];
+    }
+  }
+}
+
+template<typename T>
+static void test_1d(size_t n, ptrdiff_t shift)
+{
+  std::vector<T> src(n), dst1(n), dst2(n);
+  neon_xoshiro128pp rng(1000 + n);
+  rng.fill_bytes(src.data(), n * sizeof(T));
+  roll_2d_pure_c(src, &dst1, n, n, 1, shift, 0);
+
+  neon_roll(src.data(), dst2.data(), n, shift);
+  validate(dst1, dst2, n);
+
+  dst2 = src;
+  neon_roll_inplace(dst2.data(), n, shift);
+  validate(dst1, dst2, n);
+}
+
+template<typename T>
+static void test_2d(size_t width, size_t height, size_t stride, ptrdiff_t dx, ptrdiff_t dy)
+{
+  const auto len = stride * height;
+  std::vector<T> src(len), dst1(len), dst2(len);
+  neon_xoshiro128pp rng(1000 + width);
+  rng.fill_bytes(src.data(), len * sizeof(T));
+  // Padding past the width must be left alone.
+  dst1 = src;
+  roll_2d_pure_c(src, &dst1, stride, width, height, dx, dy);
+
+  dst2 = src;
+  neon_roll_2d(src.data(), stride, dst2.data(), stride, width, height, dx, dy);
+  validate(dst1, dst2, len);
+
+  dst2 = src;
+  neon_roll_2d_inplace(dst2.data(), stride, width, height, dx, dy);
+  validate(dst1, dst2, len);
+}
+
+template<typename T>
+static void test_type(void)
+{
+  static const size_t sizes[] = { 1, 2, 7, 16, 33, 100, 1000, 5000, 20011 };
+  static const ptrdiff_t shifts[] = { 0, 1, -1, 3, 17, -40, 999, 5000, 123456 };
+  for (const auto n : sizes) {
+    for (const auto s : shifts) {
+      test_1d<T>(n, s);
+    }
+    test_1d<T>(n, static_cast<ptrdiff_t>(n) / 2);
+  }
+  test_2d<T>(1, 1, 1, 3, -2);
+  test_2d<T>(37, 13, 40, 5, 3);
+  test_2d<T>(37, 12, 37, -10, 8);
+  test_2d<T>(64, 9, 70, 0, -4);
+  test_2d<T>(100, 30, 100, 33, 0);
+}
+
+void test_roll(void)
+{
+  test_type<uint8_t>();
+  test_type<uint16_t>();
+  test_type<uint32_t>();
+  test_type<uint64_t>();
+}
+
+void perf_roll(bench_registry* bench)
+{
+  bench->add(bench_kernel<uint32_t>("roll/copy", 32, -1, [](const uint32_t* s, uint32_t* d, size_t len) {
+    memcpy(d, s, len * sizeof(uint32_t));
+  }));
+  bench->add(bench_kernel<uint32_t>("roll/1d", 32, -1, [](const uint32_t* s, uint32_t* d, size_t len) {
+    neon_roll(s, d, len, static_cast<ptrdiff_t>(len / 3));
+  }));
+  bench->add(bench_buffer<uint32_t>("roll/1d_inplace_short", 32, -1, [](uint32_t* d, size_t len) {
+    neon_roll_inplace(d, len, 256);
+  }, bench_traffic::copy));
+  bench->add(bench_buffer<uint32_t>("roll/1d_inplace", 32, -1, [](uint32_t* d, size_t len) {
+    neon_roll_inplace(d, len, static_cast<ptrdiff_t>(len / 3));
+  }, bench_traffic::copy));
+  // Frames up to 2048 pixels wide scrolled by (5, 3).
+  bench->add(bench_buffer<uint32_t>("roll/2d_inplace", 32, -1, [](uint32_t* d, size_t len) {
+    const auto width = std::min<size_t>(len, 2048);
+    neon_roll_2d_inplace(d, width, width, len / width, 5, 3);
+  }, bench_traffic::copy));
+}
@@ -0,0 +1,163 @@
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+#include <cstring>
+
+#include <arm_neon.h>
+
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "neon_speck.h"
+#include "neon_xoshiro.h"
+#include "test_common.h"
+
+static uint32_t ror32(uint32_t x, int r)
+{
+  return (x >> r) | (x << (32 - r));
+}
+
+static uint64_t ror64(uint64_t x, int r)
+{
+  return (x >> r) | (x << (64 - r));
+}
+
+static void speck64_128_pure_c(const uint8_t* key, const uint8_t* in, uint8_t* out)
+{
+  uint32_t k[4], p[2];
+  memcpy(k, key, sizeof(k));
+  memcpy(p, in, sizeof(p));
+  uint32_t a = k[0], b = k[1], c = k[2], d = k[3];
+  uint32_t y = p[0], x = p[1];
+  for (uint32_t i = 0; i < 27; ++i) {
+    x = (ror32(x, 8) + y) ^ a;
+    y = ror32(y, 29) ^ x;
+    b = (ror32(b, 8) + a) ^ i;
+    a = ror32(a, 29) ^ b;
+    const uint32_t t = b; b = c; c = d; d = t;
+  }
+  p[0] = y;
+  p[1] = x;
+  memcpy(out, p, sizeof(p));
+}
+
+static void speck128_128_pure_c(const uint8_t* key, const uint8_t* in, uint8_t* out)
+{
+  uint64_t k[2], p[2];
+  memcpy(k, key, sizeof(k));
+  memcpy(p, in, sizeof(p));
+  uint64_t a = k[0], b = k[1];
+  uint64_t y = p[0], x = p[1];
+  for (uint64_t i = 0; i < 32; ++i) {
+    x = (ror64(x, 8) + y) ^ a;
+    y = ror64(y, 61) ^ x;
+    b = (ror64(b, 8) + a) ^ i;
+    a = ror64(a, 61) ^ b;
+  }
+  p[0] = y;
+  p[1] = x;
+  memcpy(out, p, sizeof(p));
+}
+
+// Little-endian increment of the counter block.
+static void ctr_pure_c(void (*block)(const uint8_t*, const uint8_t*, uint8_t*), size_t block_bytes,
+                       const uint8_t* key, const uint8_t* iv, const uint8_t* src, uint8_t* dst, size_t buf_len)
+{
+  uint8_t counter[16], ks[16];
+  memcpy(counter, iv, block_bytes);
+  for (size_t i = 0; i < buf_len; i += block_bytes) {
+    block(key, counter, ks);
+    for (size_t j = 0; j < block_bytes && i + j < buf_len; ++j) {
+      dst[i + j] = src[i + j] ^ ks[j];
+    }
+    for (size_t j = 0; j < block_bytes && ++counter[j] == 0; ++j) {
+    }
+  }
+}
+
+// Test vectors from "The SIMON and SPECK Families of Lightweight Block Ciphers",
+// in the byte order of the Speck implementation guide.
+static void test_vectors(void)
+{
+  static const uint8_t key64[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x08, 0x09, 0x0a, 0x0b, 0x10, 0x11, 0x12, 0x13, 0x18, 0x19, 0x1a, 0x1b
+  };
+  static const uint8_t pt64[8] = { 0x2d, 0x43, 0x75, 0x74, 0x74, 0x65, 0x72, 0x3b };
+  static const uint8_t ct64[8] = { 0x8b, 0x02, 0x4e, 0x45, 0x48, 0xa5, 0x6f, 0x8c };
+  static const uint8_t key128[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+  };
+  static const uint8_t pt128[16] = {
+    0x20, 0x6d, 0x61, 0x64, 0x65, 0x20, 0x69, 0x74, 0x20, 0x65, 0x71, 0x75, 0x69, 0x76, 0x61, 0x6c
+  };
+  static const uint8_t ct128[16] = {
+    0x18, 0x0d, 0x57, 0x5c, 0xdf, 0xfe, 0x60, 0x78, 0x65, 0x32, 0x78, 0x79, 0x51, 0x98, 0x5d, 0xa6
+  };
+
+  std::vector<uint8_t> expected64(ct64, ct64 + 8), ref64(8), out64(8);
+  speck64_128_pure_c(key64, pt64, ref64.data());
+  neon_speck64_128(key64).encrypt_block(pt64, out64.data());
+  validate(expected64, ref64, 8);
+  validate(expected64, out64, 8);
+
+  std::vector<uint8_t> expected128(ct128, ct128 + 16), ref128(16), out128(16);
+  speck128_128_pure_c(key128, pt128, ref128.data());
+  neon_speck128_128(key128).encrypt_block(pt128, out128.data());
+  validate(expected128, ref128, 16);
+  validate(expected128, out128, 16);
+}
+
+template<typename Speck>
+static void test_ctr(void (*block)(const uint8_t*, const uint8_t*, uint8_t*), size_t buf_len)
+{
+  std::vector<uint8_t> src(buf_len), dst1(buf_len), dst2(buf_len), dst3(buf_len);
+  neon_xoshiro128pp rng(1000);
+  rng.fill_bytes(src.data(), buf_len);
+  uint8_t key[16];
+  rng.fill_bytes(key, sizeof(key));
+  // The low counter word wraps after three blocks.
+  uint8_t iv[16];
+  rng.fill_bytes(iv, sizeof(iv));
+  memset(iv, 0xff, Speck::kBlockBytes / 2);
+  iv[0] = 0xfd;
+
+  const Speck speck(key);
+  ctr_pure_c(block, Speck::kBlockBytes, key, iv, src.data(), dst1.data(), buf_len);
+  speck.ctr(iv, src.data(), dst2.data(), buf_len);
+  validate(dst1, dst2, buf_len);
+
+  speck.ctr(iv, dst2.data(), dst3.data(), buf_len);
+  validate(src, dst3, buf_len);
+}
+
+void test_speck(void)
+{
+  static const size_t kBufLen = 64*1024;
+
+  test_vectors();
+  test_ctr<neon_speck64_128>(speck64_128_pure_c, kBufLen);
+  test_ctr<neon_speck64_128>(speck64_128_pure_c, kBufLen - 13);
+  test_ctr<neon_speck128_128>(speck128_128_pure_c, kBufLen);
+  test_ctr<neon_speck128_128>(speck128_128_pure_c, kBufLen - 13);
+}
+
+template<typename Speck>
+static void perf_ctr(bench_registry* bench, const std::string& name,
+                     void (*block)(const uint8_t*, const uint8_t*, uint8_t*))
+{
+  static const uint8_t key[16] = {}, iv[16] = {};
+  bench->add(bench_kernel<uint8_t>("speck/" + name + "/pure_c", 8, -1, [block](const uint8_t* s, uint8_t* d, size_t len) {
+    ctr_pure_c(block, Speck::kBlockBytes, key, iv, s, d, len);
+  }));
+  const Speck speck(key);
+  bench->add(bench_kernel<uint8_t>("speck/" + name + "/neon", 8, -1, [speck](const uint8_t* s, uint8_t* d, size_t len) {
+    speck.ctr(iv, s, d, len);
+  }));
+}
+
+void perf_speck(bench_registry* bench)
+{
+  perf_ctr<neon_speck64_128>(bench, "64_128", speck64_128_pure_c);
+  perf_ctr<neon_speck128_128>(bench, "128_128", speck128_128_pure_c);
+}
@@ -6,10 +6,11 @@
 #include <arm_neon.h>
 
 #include <vector>
-#include <random>
-#include <chrono>
 
 #include "neon_circular_shift.h"
+#include "bench.h"
+#include "bench_baselines.h"
+#include "neon_xoshiro.h"
 #include "test_common.h"
 
 static uint8_t shift_l_circular_n_u8(uint8_t v, int n)
@@ -98,75 +99,55 @@ static void test_neon_slow_q(const std::vector<uint8_t>& src, std::vector<uint8_
 }
 
 template<int n>
-static void perf_pure_c(const std::vector<uint8_t>& src, std::vector<uint8_t>* dst, size_t buf_len)
+static void perf_pure_c(const uint8_t* s, uint8_t* d, size_t buf_len)
 {
-  const auto s = src.data();
-  auto d = dst->data();
-  const int m = (n + static_cast<int>(src[0])) % 8;
   for (size_t i = 0; i < buf_len; ++i) {
-    auto ret = shift_l_circular_n_u8(s[i], (n + 0) % 8);
-    ret = shift_l_circular_n_u8(ret, (m + 1) % 8);
-    ret = shift_l_circular_n_u8(ret, (m + 2) % 8);
-    ret = shift_l_circular_n_u8(ret, (m + 3) % 8);
-    ret = shift_l_circular_n_u8(ret, (m + 4) % 8);
-    ret = shift_l_circular_n_u8(ret, (m + 5) % 8);
-    ret = shift_l_circular_n_u8(ret, (m + 6) % 8);
-    ret = shift_l_circular_n_u8(ret, (m + 7) % 8);
-    d[i] = ret;
+    d[i] = shift_l_circular_n_u8(s[i], n);
   }
 }
 
 template<int n>
-static void perf_copy(const std::vector<uint8_t>& src, std::vector<uint8_t>* dst, size_t buf_len)
+static uint8_t perf_rotl_pure_c(uint8_t v)
+{
+  return shift_l_circular_n_u8(v, n);
+}
+
+static void perf_copy(const uint8_t* s, uint8_t* d, size_t buf_len)
 {
-  const auto s = src.data();
-  auto d = dst->data();
   for (size_t i = 0; i < buf_len; ++i) {
     d[i] = s[i];
   }
 }
 
-#define PERF_NEON(func, src, dst, buf_len, n, stride, ld, st) \
-{ \
-  const auto s = src.data(); \
-  auto d = dst->data(); \
+#define PERF_NEON(func, s, d, buf_len, n, stride, ld, st) \
   for (size_t i = 0; i < buf_len; i += stride) { \
-    auto ret = ld(s + i); \
-    ret = func<(n + 0) % 8>(ret); \
-    ret = func<(n + 1) % 8>(ret); \
-    ret = func<(n + 2) % 8>(ret); \
-    ret = func<(n + 3) % 8>(ret); \
-    ret = func<(n + 4) % 8>(ret); \
-    ret = func<(n + 5) % 8>(ret); \
-    ret = func<(n + 6) % 8>(ret); \
-    ret = func<(n + 7) % 8>(ret); \
+    const auto v = ld(s + i); \
+    const auto ret = func<n>(v); \
     st(d + i, ret); \
-  } \
-}
-
+  }
 
 template<int n>
-static void perf_neon(const std::vector<uint8_t>& src, std::vector<uint8_t>* dst, size_t buf_len)
+static void perf_neon(const uint8_t* s, uint8_t* d, size_t buf_len)
 {
-  PERF_NEON(vshlc_n_u8, src, dst, buf_len, n, 8, vld1_u8, vst1_u8);
+  PERF_NEON(vshlc_n_u8, s, d, buf_len, n, 8, vld1_u8, vst1_u8);
 }
 
 template<int n>
-static void perf_neon_slow(const std::vector<uint8_t>& src, std::vector<uint8_t>* dst, size_t buf_len)
+static void perf_neon_slow(const uint8_t* s, uint8_t* d, size_t buf_len)
 {
-  PERF_NEON(vshlc_slow_n_u8, src, dst, buf_len, n, 8, vld1_u8, vst1_u8);
+  PERF_NEON(vshlc_slow_n_u8, s, d, buf_len, n, 8, vld1_u8, vst1_u8);
 }
 
 template<int n>
-static void perf_neon_q(const std::vector<uint8_t>& src, std::vector<uint8_t>* dst, size_t buf_len)
+static void perf_neon_q(const uint8_t* s, uint8_t* d, size_t buf_len)
 {
-  PERF_NEON(vshlcq_n_u8, src, dst, buf_len, n, 16, vld1q_u8, vst1q_u8);
+  PERF_NEON(vshlcq_n_u8, s, d, buf_len, n, 16, vld1q_u8, vst1q_u8);
 }
 
 template<int n>
-static void perf_neon_slow_q(const std::vector<uint8_t>& src, std::vector<uint8_t>* dst, size_t buf_len)
+static void perf_neon_slow_q(const uint8_t* s, uint8_t* d, size_t buf_len)
 {
-  PERF_NEON(vshlcq_slow_n_u8, src, dst, buf_len, n, 16, vld1q_u8, vst1q_u8);
+  PERF_NEON(vshlcq_slow_n_u8, s, d, buf_len, n, 16, vld1q_u8, vst1q_u8);
 }
 
 #define GEN_TEST_SUB(ref_func, test_func, src, dst1, dst2, buf_len, validate, n) \
@@ -183,15 +164,6 @@ static void perf_neon_slow_q(const std::vector<uint8_t>& src, std::vector<uint8_
   GEN_TEST_SUB(ref_func, test_func, src, dst1, dst2, buf_len, validate, 6); \
   GEN_TEST_SUB(ref_func, test_func, src, dst1, dst2, buf_len, validate, 7); \
 
-#define GEN_PERF(func, src, dst, buf_len) \
-  func<1>(src, dst, buf_len); \
-  func<2>(src, dst, buf_len); \
-  func<3>(src, dst, buf_len); \
-  func<4>(src, dst, buf_len); \
-  func<5>(src, dst, buf_len); \
-  func<6>(src, dst, buf_len); \
-  func<7>(src, dst, buf_len); \
-
 void test_u8(void)
 {
   static const size_t kBufLen = 256;
@@ -204,49 +176,16 @@ void test_u8(void)
   GEN_TEST(test_pure_c, test_neon_slow, src, dst1, dst2, kBufLen, validate);
 }
 
-void perf_u8(void)
+void perf_u8(bench_registry* bench)
 {
-  static const size_t kBufLen = 8*1024*1024;
-  std::vector<uint8_t> src(kBufLen), dst1(kBufLen), dst2(kBufLen);
-  std::mt19937 mt(1000);
-  for (size_t i = 0; i < kBufLen; ++i) {
-    src[i] = mt();
-  }
-
-  const size_t kLoop = 10;
-  const auto a_begin = std::chrono::high_resolution_clock::now();
-  for (size_t i = 0; i < kLoop; ++i) {
-    GEN_PERF(perf_copy, src, &dst1, kBufLen);
-  }
-  const auto a_end = std::chrono::high_resolution_clock::now();
-
-  const auto c_begin = std::chrono::high_resolution_clock::now();
-  for (size_t i = 0; i < kLoop; ++i) {
-    GEN_PERF(perf_pure_c, src, &dst1, kBufLen);
-  }
-  const auto c_end = std::chrono::high_resolution_clock::now();
-
-  const auto nf_begin = std::chrono::high_resolution_clock::now();
-  for (size_t i = 0; i < kLoop; ++i) {
-    GEN_PERF(perf_neon, src, &dst1, kBufLen);
-  }
-  const auto nf_end = std::chrono::high_resolution_clock::now();
-
-  const auto ns_begin = std::chrono::high_resolution_clock::now();
-  for (size_t i = 0; i < kLoop; ++i) {
-    GEN_PERF(perf_neon_slow, src, &dst1, kBufLen);
-  }
-  const auto ns_end = std::chrono::high_resolution_clock::now();
-
-  const auto a_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(a_end - a_begin);
-  const auto c_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(c_end - c_begin);
-  const auto nf_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(nf_end - nf_begin);
-  const auto ns_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(ns_end - ns_begin);
-
-  printf("%s copy  : %" PRIu64 "\n", __FUNCTION__, a_elapsed.count());
-  printf("%s pure c: %" PRIu64 "\n", __FUNCTION__, c_elapsed.count());
-  printf("%s neon f: %" PRIu64 "\n", __FUNCTION__, nf_elapsed.count());
-  printf("%s neon s: %" PRIu64 "\n", __FUNCTION__, ns_elapsed.count());
+  bench->add(bench_kernel<uint8_t>("u8/copy", 8, -1, perf_copy));
+  BENCH_SHIFTS(bench, uint8_t, "u8/pure_c", perf_pure_c);
+  BENCH_SHIFTS(bench, uint8_t, "u8/d/neon", perf_neon);
+  BENCH_SHIFTS(bench, uint8_t, "u8/d/neon_slow", perf_neon_slow);
+  BENCH_CHAINS(bench, uint8_t, 8, "u8/pure_c", perf_rotl_pure_c);
+  BENCH_CHAINS(bench, uint8x8_t, 8, "u8/d/neon", vshlc_n_u8);
+  BENCH_CHAINS(bench, uint8x8_t, 8, "u8/d/neon_slow", vshlc_slow_n_u8);
+  bench_add_compiler_baselines<uint8_t>(bench, "u8");
 }
 
 void test_q_u8(void)
@@ -261,48 +200,11 @@ void test_q_u8(void)
   GEN_TEST(test_pure_c, test_neon_slow_q, src, dst1, dst2, kBufLen, validate);
 }
 
-void perf_q_u8(void)
+void perf_q_u8(bench_registry* bench)
 {
-  static const size_t kBufLen = 8*1024*1024;
-  std::vector<uint8_t> src(kBufLen), dst1(kBufLen), dst2(kBufLen);
-  std::mt19937 mt(1000);
-  for (size_t i = 0; i < kBufLen; ++i) {
-    src[i] = mt();
-  }
-
-  const size_t kLoop = 10;
-  const auto a_begin = std::chrono::high_resolution_clock::now();
-  for (size_t i = 0; i < kLoop; ++i) {
-    GEN_PERF(perf_copy, src, &dst1, kBufLen);
-  }
-  const auto a_end = std::chrono::high_resolution_clock::now();
-
-  const auto c_begin = std::chrono::high_resolution_clock::now();
-  for (size_t i = 0; i < kLoop; ++i) {
-    GEN_PERF(perf_pure_c, src, &dst1, kBufLen);
-  }
-  const auto c_end = std::chrono::high_resolution_clock::now();
-
-  const auto nf_begin = std::chrono::high_resolution_clock::now();
-  for (size_t i = 0; i < kLoop; ++i) {
-    GEN_PERF(perf_neon_q, src, &dst1, kBufLen);
-  }
-  const auto nf_end = std::chrono::high_resolution_clock::now();
-
-  const auto ns_begin = std::chrono::high_resolution_clock::now();
-  for (size_t i = 0; i < kLoop; ++i) {
-    GEN_PERF(perf_neon_slow_q, src, &dst1, kBufLen);
-  }
-  const auto ns_end = std::chrono::high_resolution_clock::now();
-
-  const auto a_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(a_end - a_begin);
-  const auto c_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(c_end - c_begin);
-  const auto nf_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(nf_end - nf_begin);
-  const auto ns_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(ns_end - ns_begin);
-
-  printf("%s copy  : %" PRIu64 "\n", __FUNCTION__, a_elapsed.count());
-  printf("%s pure c: %" PRIu64 "\n", __FUNCTION__, c_elapsed.count());
-  printf("%s neon f: %" PRIu64 "\n", __FUNCTION__, nf_elapsed.count());
-  printf("%s neon s: %" PRIu64 "\n", __FUNCTION__, ns_elapsed.count());
+  BENCH_SHIFTS(bench, uint8_t, "u8/q/neon", perf_neon_q);
+  BENCH_SHIFTS(bench, uint8_t, "u8/q/neon_slow", perf_neon_slow_q);
+  BENCH_CHAINS(bench, uint8x16_t, 8, "u8/q/neon", vshlcq_n_u8);
+  BENCH_CHAINS(bench, uint8x16_t, 8, "u8/q/neon_slow", vshlcq_slow_n_u8);
 }
 
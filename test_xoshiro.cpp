@@ -0,0 +1,242 @@
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+#include <cstring>
+
+#include <arm_neon.h>
+
+#include <vector>
+#include <memory>
+#include <random>
+
+#include "bench.h"
+#include "neon_xoshiro.h"
+#include "test_common.h"
+
+static uint64_t splitmix64(uint64_t* x)
+{
+  uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static uint32_t rotl32(uint32_t x, int k)
+{
+  return (x << k) | (x >> (32 - k));
+}
+
+static uint64_t rotl64(uint64_t x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+struct ref_xoshiro128pp {
+  uint32_t s[4];
+
+  uint32_t next()
+  {
+    const uint32_t result = rotl32(s[0] + s[3], 7) + s[0];
+    const uint32_t t = s[1] << 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl32(s[3], 11);
+    return result;
+  }
+
+  void jump()
+  {
+    static const uint32_t JUMP[] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+    uint32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (size_t i = 0; i < sizeof(JUMP) / sizeof(*JUMP); i++) {
+      for (int b = 0; b < 32; b++) {
+        if (JUMP[i] & UINT32_C(1) << b) {
+          s0 ^= s[0];
+          s1 ^= s[1];
+          s2 ^= s[2];
+          s3 ^= s[3];
+        }
+        next();
+      }
+    }
+    s[0] = s0;
+    s[1] = s1;
+    s[2] = s2;
+    s[3] = s3;
+  }
+
+  void seed(uint64_t x)
+  {
+    const uint64_t a = splitmix64(&x);
+    const uint64_t b = splitmix64(&x);
+    s[0] = static_cast<uint32_t>(a);
+    s[1] = static_cast<uint32_t>(a >> 32);
+    s[2] = static_cast<uint32_t>(b);
+    s[3] = static_cast<uint32_t>(b >> 32);
+  }
+};
+
+struct ref_xoshiro256ss {
+  uint64_t s[4];
+
+  uint64_t next()
+  {
+    const uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return result;
+  }
+
+  void jump()
+  {
+    static const uint64_t JUMP[] = {
+      0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+    };
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (size_t i = 0; i < sizeof(JUMP) / sizeof(*JUMP); i++) {
+      for (int b = 0; b < 64; b++) {
+        if (JUMP[i] & UINT64_C(1) << b) {
+          s0 ^= s[0];
+          s1 ^= s[1];
+          s2 ^= s[2];
+          s3 ^= s[3];
+        }
+        next();
+      }
+    }
+    s[0] = s0;
+    s[1] = s1;
+    s[2] = s2;
+    s[3] = s3;
+  }
+
+  void seed(uint64_t x)
+  {
+    for (int i = 0; i < 4; ++i) {
+      s[i] = splitmix64(&x);
+    }
+  }
+};
+
+struct ref_xoroshiro128p {
+  uint64_t s[2];
+
+  uint64_t next()
+  {
+    const uint64_t s0 = s[0];
+    uint64_t s1 = s[1];
+    const uint64_t result = s0 + s1;
+    s1 ^= s0;
+    s[0] = rotl64(s0, 24) ^ s1 ^ (s1 << 16);
+    s[1] = rotl64(s1, 37);
+    return result;
+  }
+
+  void jump()
+  {
+    static const uint64_t JUMP[] = { 0xdf900294d8f554a5ULL, 0x170865df4b3201fcULL };
+    uint64_t s0 = 0, s1 = 0;
+    for (size_t i = 0; i < sizeof(JUMP) / sizeof(*JUMP); i++) {
+      for (int b = 0; b < 64; b++) {
+        if (JUMP[i] & UINT64_C(1) << b) {
+          s0 ^= s[0];
+          s1 ^= s[1];
+        }
+        next();
+      }
+    }
+    s[0] = s0;
+    s[1] = s1;
+  }
+
+  void seed(uint64_t x)
+  {
+    for (int i = 0; i < 2; ++i) {
+      s[i] = splitmix64(&x);
+    }
+  }
+};
+
+// Stream k of a generator that was jumped j times starts at the seeded state
+// advanced by (j * kStreams + k) jumps.
+template<typename Ref, typename T>
+static void ref_fill(uint64_t seed, int streams, int jumps, std::vector<T>* dst, size_t buf_len)
+{
+  std::vector<Ref> refs(streams);
+  Ref r;
+  r.seed(seed);
+  for (int i = 0; i < jumps * streams; ++i) {
+    r.jump();
+  }
+  for (int k = 0; k < streams; ++k) {
+    refs[k] = r;
+    r.jump();
+  }
+  auto d = dst->data();
+  for (size_t i = 0; i < buf_len; ++i) {
+    d[i] = static_cast<T>(refs[i % streams].next());
+  }
+}
+
+template<typename Gen, typename Ref, typename T>
+static void test_gen(size_t buf_len)
+{
+  std::vector<T> dst1(buf_len), dst2(buf_len), dst3(buf_len);
+
+  ref_fill<Ref>(1000, Gen::kStreams, 0, &dst1, buf_len);
+  Gen gen(1000);
+  gen.fill(dst2.data(), buf_len);
+  validate(dst1, dst2, buf_len);
+
+  Gen bytes(1000);
+  bytes.fill_bytes(dst3.data(), buf_len * sizeof(T));
+  validate(dst1, dst3, buf_len);
+
+  ref_fill<Ref>(1000, Gen::kStreams, 1, &dst1, buf_len);
+  Gen jumped(1000);
+  jumped.jump();
+  jumped.fill(dst2.data(), buf_len);
+  validate(dst1, dst2, buf_len);
+}
+
+void test_xoshiro(void)
+{
+  static const size_t kBufLen = 64*1024;
+
+  test_gen<neon_xoshiro128pp, ref_xoshiro128pp, uint32_t>(kBufLen);
+  test_gen<neon_xoshiro128pp, ref_xoshiro128pp, uint32_t>(kBufLen - 3);
+  test_gen<neon_xoshiro256ss, ref_xoshiro256ss, uint64_t>(kBufLen);
+  test_gen<neon_xoshiro256ss, ref_xoshiro256ss, uint64_t>(kBufLen - 1);
+  test_gen<neon_xoroshiro128p, ref_xoroshiro128p, uint64_t>(kBufLen);
+  test_gen<neon_xoroshiro128p, ref_xoroshiro128p, uint64_t>(kBufLen - 1);
+}
+
+void perf_xoshiro(bench_registry* bench)
+{
+  auto mt = std::make_shared<std::mt19937>(1000);
+  bench->add(bench_buffer<uint32_t>("xoshiro/mt19937", 32, -1, [mt](uint32_t* dst, size_t len) {
+    for (size_t j = 0; j < len; ++j) {
+      dst[j] = (*mt)();
+    }
+  }));
+  auto x128 = std::make_shared<neon_xoshiro128pp>(1000);
+  bench->add(bench_buffer<uint32_t>("xoshiro/xoshiro128pp", 32, -1, [x128](uint32_t* dst, size_t len) {
+    x128->fill(dst, len);
+  }));
+  auto x256 = std::make_shared<neon_xoshiro256ss>(1000);
+  bench->add(bench_buffer<uint64_t>("xoshiro/xoshiro256ss", 64, -1, [x256](uint64_t* dst, size_t len) {
+    x256->fill(dst, len);
+  }));
+  auto xo128 = std::make_shared<neon_xoroshiro128p>(1000);
+  bench->add(bench_buffer<uint64_t>("xoshiro/xoroshiro128p", 64, -1, [xo128](uint64_t* dst, size_t len) {
+    xo128->fill(dst, len);
+  }));
+}